@@ -34,9 +34,35 @@ extern const char SW_TAG[6] = "BETA";
  *   allows about 68 years of timestamps before overflow.
  *
  * Performance notes:
+ * - Each event is split into fetch() (SPI register reads + interrupt
+ *   ack) and compute_tof() (ring-oscillator math).  The chip is re-armed
+ *   between the two, so dead time after an event is just the SPI
+ *   traffic; the math and formatting overlap the next measurement.
+ *   loop() fetches and re-arms every ready chip first and only then
+ *   computes, so simultaneous A/B completions are both re-armed
+ *   back-to-back.
+ *   PICstop is latched in fetch() because the STOP ISR may overwrite
+ *   it once the chip is armed again.
+ * - SPI traffic per event is kept small: adjacent result registers are
+ *   read in auto-increment bursts, interrupts are cleared with a single
+ *   blind INT_STATUS write, and config register writes go through a
+ *   shadow copy so unchanged values are never resent.  Debug mode shows
+ *   the per-event transaction count (spi_xfers): 5 (INT_STATUS read,
+ *   result burst, calibration burst, interrupt ack, re-arm), or 4 when
+ *   calibration is cached.  INT_STATUS is an 8-bit register well away
+ *   from the 24-bit results, so it can't share their burst.
  * - Coarse time (seconds + remainder ticks) is derived incrementally
  *   per hit, avoiding per-event 64‑bit division/modulo. A fallback 
  *   recomputes directly if a large jump is detected (startup or resync).
+ * - With the stock 10 MHz / 100 us timebase (default_timebase), the
+ *   per-event math is instantiated on DefaultTimebase constants and the
+ *   clock1 multiply is 32-bit.  Other clocks use ConfigTimebase.
+ * - When the coarse tick is a whole number of microseconds, the
+ *   remainder maps to frac_hi as rem * tick_us.  compute_tof_split()
+ *   builds tof in the same (us, ps) form and the offsets are split once
+ *   when set, so timestamp assembly is 32-bit adds with borrow and no
+ *   64-bit multiply or divide runs per event.  Other timebases, or
+ *   offsets of 0.5 s or more, use the 64-bit ps path.
  * - Printing is buffered: each output line is assembled into a stack 
  *   buffer and emitted with a single Serial.write(), reducing per-line 
  *   I/O overhead while preserving the exact text format.
@@ -64,11 +90,15 @@ extern const char SW_TAG[6] = "BETA";
  *   integer seconds and zero‑padded fractional parts using 32‑bit 
  *   helpers. Each line is buffered then emitted with a single 
  *   Serial.write() for lower overhead.
- * - We use writeln64() (in misc.cpp)to write lines to the serial port.
- *   This function is a wrapper around Serial.write() that ensures
- *   the line is terminated with a newline character.  NOTE: This
- *   wrapper is limited to 64 characters, which is more than sufficient
- *   for all TICC data output formats.
+ * - Data lines are built in a LineRecord (record.h) sized for the mode
+ *   at compile time: the formatters write into it directly, channel
+ *   tags are copied from ch_tag/ti_tag (built once from the names) and
+ *   counters are converted without sprintf().  send() adds CRLF and
+ *   hands the line to out_record() (output.cpp) whole.  Comment lines
+ *   use writeln() (misc.cpp), which does the same for a plain buffer.
+ * - out_record() applies the overload policy (config.OVERLOAD) when the
+ *   TX ring is full and counts what it drops; comment output that goes
+ *   straight to Serial is preceded by out_flush().
  *
  * Why signed:
  * - We frequently subtract (period = ts − last_ts; interval = B − A). 
@@ -90,6 +120,13 @@ extern const char SW_TAG[6] = "BETA";
 #include "misc.h"             // random functions
 #include "board.h"            // Arduino pin definitions
 #include "tdc7200.h"          // TDC registers and structures
+#include "uart0.h"            // USART0 driver; remaps Serial
+#include "output.h"           // record output and overload policy
+#include "aggregate.h"        // Period/Interval gate statistics
+#include "adev.h"             // streaming ADEV/MDEV
+#include "freq.h"             // least-squares frequency counter
+#include "hist.h"             // time interval histogram
+#include "record.h"           // output line builder
 
 volatile int64_t PICcount;
 int64_t CLOCK_HZ;
@@ -98,6 +135,9 @@ int64_t CLOCK_PERIOD;
 int16_t CAL_PERIODS;
 int16_t WRAP;
 int64_t ticksPerSecond;  // number of coarse ticks per second
+int32_t pictick_us;      // PICTICK_PS in whole microseconds, 0 if not a multiple
+uint32_t clock_per_us;   // reference clocks per microsecond, 0 if not a divisor
+bool default_timebase;   // clock and coarse tick match the config.h defaults
 
 config_t config;
 MeasureMode MODE, lastMODE;
@@ -109,10 +149,132 @@ static config_t config_backup;  // Backup of config before changes
 uint8_t config_changed = 0;  // Flag indicating config was modified (global for config.cpp access)
 static uint8_t config_requested = 0;  // Flag indicating user requested config menu
 
-static tdc7200Channel channels[] = {
-  tdc7200Channel('0', ENABLE_0, INTB_0, CSB_0, STOP_0, LED_0),
-  tdc7200Channel('1', ENABLE_1, INTB_1, CSB_1, STOP_1, LED_1),
-};
+#define CHANNEL_ENTRY(id, en, intb, csb, stop, led) tdc7200Channel(id, en, intb, csb, stop, led)
+static tdc7200Channel channels[NUM_CHANNELS] = { CHANNEL_TABLE };
+#undef CHANNEL_ENTRY
+static const uint8_t ch_led_mask[NUM_CHANNELS] = CHANNEL_LED_MASKS;
+static_assert(NUM_CHANNELS >= 2 && NUM_CHANNELS <= 8, "fetched bitmask in loop() holds 8 channels");
+
+// Split a fetched channel's PICstop_latched and tof into ts_split.
+// TB is DefaultTimebase or ConfigTimebase (see tdc7200.h); loop() picks
+// the instantiation once per event from default_timebase.
+template <class TB>
+static void stamp_channel(tdc7200Channel &ch) {
+  // Derive coarse seconds and remainder ticks using incremental method
+  // Incremental coarse-time decomposition to avoid 64-bit div/mod per hit
+  // Assumption: at most one second of ticks elapsed since last sample.
+  // We handle a single carry into seconds when delta ≤ ticksPerSecond.
+  // If delta is negative or requires more than one carry (delta > ticksPerSecond),
+  // the incremental state (cached_sec/cached_rem_ticks) would drift, so we realign
+  // by recomputing sec and remainder directly from PICstop (fallback path below).
+  int64_t sec;
+  int32_t remTicks32;
+  int64_t delta = ch.PICstop_latched - ch.last_picstop;
+  ch.last_picstop = ch.PICstop_latched;
+  if (delta >= 0 && delta <= TB::ticks_per_sec()) {
+    int32_t rem = ch.cached_rem_ticks + (int32_t)delta;
+    if (rem >= TB::ticks_per_sec()) {
+      rem -= TB::ticks_per_sec();
+      ch.cached_sec++;
+    }
+    ch.cached_rem_ticks = rem;
+  } else {
+    // Fallback for startup/large jumps: recompute from absolute PICstop
+    ch.cached_sec = (int32_t)(ch.PICstop_latched / TB::ticks_per_sec());
+    ch.cached_rem_ticks = (int32_t)(ch.PICstop_latched % TB::ticks_per_sec());
+  }
+  sec = ch.cached_sec;
+  remTicks32 = ch.cached_rem_ticks;
+
+  // Whole-microsecond tick (the stock 100 us one included): the coarse
+  // remainder is exactly rem * tick_us in the 1e6 ps units of frac_hi,
+  // and compute_tof_split() left tof in the same units, so assembly is
+  // 32-bit adds with borrow.  Taken when tof is in [0, 0.5 s) and the
+  // offset in [-0.5 s, 0.5 s), where at most one borrow or carry into
+  // the seconds is needed and the result is identical to the ps path.
+  int32_t tick_us = TB::tick_us();
+  if (tick_us && ch.tof_is_split && ch.offset_is_split &&
+      (ch.tof_hi >= 0) && (ch.tof_hi < 500000L) &&
+      (ch.offset_hi >= -500000L) && (ch.offset_hi < 500000L)) {
+    int32_t sub_hi = ch.tof_hi + ch.offset_hi;
+    int32_t sub_lo = (int32_t)(ch.tof_lo + ch.offset_lo);
+    if (sub_lo >= 1000000L) {
+      sub_lo -= 1000000L;
+      sub_hi += 1;
+    }
+    int32_t hi = remTicks32 * tick_us - sub_hi;
+    int32_t lo = -sub_lo;
+    if (lo < 0) {
+      lo += 1000000L;
+      hi -= 1;
+    }
+    if (hi < 0) {
+      hi += 1000000L;
+      sec -= 1;
+    } else if (hi >= 1000000L) {
+      hi -= 1000000L;
+      sec += 1;
+    }
+    ch.ts_split.sec = (int32_t)sec;
+    ch.ts_split.frac_hi = (uint32_t)hi;
+    ch.ts_split.frac_lo = (uint32_t)lo;
+    return;
+  }
+
+  // ps path: subtract tof and the channel offset, then bring the
+  // remainder back into [0, 1 s) with one floor division, so a bad tof
+  // or offset costs a divide rather than a loop
+  int64_t remPs = TB::tick_ps(remTicks32) - ch.tof_ps() - ch.offset;
+  int64_t carry = remPs / PS_PER_SEC;
+  remPs -= carry * PS_PER_SEC;
+  if (remPs < 0) {
+    remPs += PS_PER_SEC;
+    carry -= 1;
+  }
+  sec += carry;
+  ch.ts_split.sec = (int32_t)sec;
+  ch.ts_split.frac_hi = (uint32_t)(remPs / 1000000LL);
+  ch.ts_split.frac_lo = (uint32_t)(remPs % 1000000LL);
+}
+
+// Line tags, rebuilt from the channel names by build_tags(): " chA"
+// per channel and " TI(A->B)" per pair
+static char ch_tag[NUM_CHANNELS][REC_CH_TAG_LEN];
+static char ti_tag[NUM_CHANNELS / 2][REC_TI_TAG_LEN];
+
+static void build_tags() {
+  for (size_t i = 0; i < NUM_CHANNELS; ++i) {
+    memcpy(ch_tag[i], " ch", 3);
+    ch_tag[i][3] = (char)channels[i].name;
+  }
+  for (size_t p = 0; p < NUM_CHANNELS / 2; ++p) {
+    memcpy(ti_tag[p], " TI(A->B)", REC_TI_TAG_LEN);
+    ti_tag[p][4] = (char)('A' + 2 * p);
+    ti_tag[p][7] = (char)('B' + 2 * p);
+  }
+}
+
+// config.SEQUENCE: tag a data line with its event's count (output.h)
+template <size_t CAP>
+static void put_seq(LineRecord<CAP> &r, int64_t seq) {
+  if (config.SEQUENCE != 'Y') return;
+  r.put(' ');
+  r.put_dec((uint32_t)seq);
+}
+
+// out_report() reads the timeout counts from the channels themselves
+static uint32_t channel_timeouts(uint8_t ch) {
+  return channels[ch].timeouts;
+}
+
+// Send one gate's statistics (aggregate.h) as a text line, whatever
+// config.FORMAT is; tag names the channel or pair
+static void write_aggregate(const AggStats &s, uint8_t ch, const char *tag, uint8_t tag_len) {
+  LineRecord<128> r;
+  r.grow(formatAggregate(r.end(), r.room() - tag_len, s, config.PLACES));
+  r.put(tag, tag_len);
+  r.send(ch);
+}
 
 /****************************************************************
 We don't use the default setup() routine -- see
@@ -136,12 +298,17 @@ uint8_t config_change_requires_restart() {
   if (config.CLOCK_HZ != config_backup.CLOCK_HZ) return 1;
   if (config.PICTICK_PS != config_backup.PICTICK_PS) return 1;
   if (config.CAL_PERIODS != config_backup.CAL_PERIODS) return 1;
-  if (config.START_EDGE[0] != config_backup.START_EDGE[0]) return 1;
-  if (config.START_EDGE[1] != config_backup.START_EDGE[1]) return 1;
+  for (size_t i = 0; i < NUM_CHANNELS; ++i) {
+    if (config.START_EDGE[i] != config_backup.START_EDGE[i]) return 1;
+  }
   if (config.SYNC_MODE != config_backup.SYNC_MODE) return 1;
+  if (config.BAUD != config_backup.BAUD) return 1;
   
   // These parameters can be changed with just a flush
-  // MODE, POLL_CHAR, WRAP, PLACES, NAME, PROP_DELAY, TIME_DILATION, FIXED_TIME2, FUDGE0, TIMEOUT
+  // MODE, POLL_CHAR, WRAP, PLACES, NAME, PROP_DELAY, TIME_DILATION, FIXED_TIME2, FUDGE0, TIMEOUT,
+  // TIMEOUT_MODE, CAL_FILTER, CAL_REFRESH, CAL_DRIFT, FORMAT, OVERLOAD, OVERLOAD_N,
+  // AGGREGATE, AGG_GATE, ADEV, ADEV_PERIOD, FREQ_GATE, FREQ_NOMINAL,
+  // HIST_LO, HIST_WIDTH, HIST_GATE, SEQUENCE
   return 0;
 }
 
@@ -155,21 +322,48 @@ void apply_config_changes() {
   CAL_PERIODS = config.CAL_PERIODS;
   WRAP = config.WRAP;
   ticksPerSecond = PS_PER_SEC / PICTICK_PS;
+  pictick_us = (PICTICK_PS % 1000000 == 0) ? (int32_t)(PICTICK_PS / 1000000) : 0;
+  clock_per_us = (1000000 % CLOCK_PERIOD == 0) ? (uint32_t)(1000000 / CLOCK_PERIOD) : 0;
+  default_timebase = (CLOCK_HZ == DEFAULT_CLOCK_HZ) && (PICTICK_PS == DEFAULT_PICTICK_PS);
 
   // Update channel-specific settings
   for (size_t i = 0; i < ARRAY_SIZE(channels); ++i) {
     channels[i].name = config.NAME[i];
-    channels[i].prop_delay = config.PROP_DELAY[i];
+    channels[i].start_edge = config.START_EDGE[i];
     channels[i].time_dilation = config.TIME_DILATION[i];
     channels[i].fixed_time2 = config.FIXED_TIME2[i];
-    channels[i].fudge = config.PROP_DELAY[i] + config.FUDGE0[i];
+    channels[i].set_offset(config.PROP_DELAY[i], config.FUDGE0[i]);
   }
+  build_tags();
 }
 
-// Flush all channels and reset their state
+// Flush all channels and reset their state.  The flushes run in
+// parallel and finish as soon as every chip reports idle.
 void flush_all_channels() {
-  for (size_t i = 0; i < ARRAY_SIZE(channels); ++i) {
-    channels[i].flush_and_reset();
+  size_t i;
+  for (i = 0; i < ARRAY_SIZE(channels); ++i) {
+    channels[i].begin_flush();
+  }
+  bool done;
+  do {
+    done = true;
+    for (i = 0; i < ARRAY_SIZE(channels); ++i) {
+      if (!channels[i].poll_flush()) done = false;
+    }
+  } while (!done);
+}
+
+// Discard pending serial input, waiting only as long as characters keep
+// arriving (two 10-bit character times at the current baud rate)
+// instead of a fixed delay
+void drain_serial_input() {
+  uint32_t gap = 20000000UL / (uint32_t)Serial.baud();
+  uint32_t last = micros();
+  while ((uint32_t)(micros() - last) < gap) {
+    if (Serial.available()) {
+      (void)Serial.read();
+      last = micros();
+    }
   }
 }
 
@@ -197,7 +391,7 @@ void handle_config_change_exit() {
   if (config_change_requires_restart()) {
     // Full restart required
     Serial.println("# Configuration changes require restart. Restarting...");
-    delay(1000);
+    Serial.flush();
     return; // This will cause ticc_setup() to be called again
   } else {
     // Can resume with flush
@@ -216,25 +410,29 @@ void ticc_setup() {
 
   size_t i;
   boolean last_pin;
+  // Restart after a config change: the serial link is up and any client
+  // boards are already running, so skip the cold-boot settle delays
+  bool warm = skip_config_prompt_once;
 
   pinMode(COARSEint, INPUT);
   pinMode(OUT1, OUTPUT);
   pinMode(OUT2, OUTPUT);
-  pinMode(EXT_LED_0, OUTPUT);  // need to set these here; on-board LEDs are set up in TDC7200::setup
-  pinMode(EXT_LED_1, OUTPUT);
+  static const uint8_t ext_leds[NUM_CHANNELS] = CHANNEL_EXT_LEDS;
+  for (i = 0; i < NUM_CHANNELS; ++i) {
+    pinMode(ext_leds[i], OUTPUT);  // need to set these here; on-board LEDs are set up in TDC7200::setup
+  }
   pinMode(EXT_LED_CLK, OUTPUT);
 
   // turn on the LEDs to show we're alive -- use macros from board.h
-  SET_LED_0;
-  SET_EXT_LED_0;
-  SET_LED_1;
-  SET_EXT_LED_1;
+  for (i = 0; i < NUM_CHANNELS; ++i) SET_CH_LED(ch_led_mask[i]);
 
   // start the serial library
-  Serial.end();  // first close in case we've come here from a break
-  Serial.begin(115200);
-  // Allow host CDC/TTY stack to settle to avoid buffered prompts on reconnect
-  delay(1500);
+  if (!warm) {
+    Serial.end();  // first close in case we've come here from a break
+    Serial.begin(BOOT_BAUD);  // config.BAUD is applied after the config prompt
+    // Allow host CDC/TTY stack to settle to avoid buffered prompts on reconnect
+    delay(1500);
+  }
   Serial.flush();
   // start the SPI library:
   SPI.end();  // first close in case we've come here from a break
@@ -273,6 +471,21 @@ void ticc_setup() {
   } else {
     skip_config_prompt_once = 0;
   }
+
+  // The banner and config prompt go out at BOOT_BAUD, so a board set to
+  // a rate the host can't open stays reachable on every power-up
+  if (Serial.baud() != config.BAUD) {
+    Serial.print("# Switching to ");
+    Serial.print(config.BAUD);
+    Serial.println(" baud");
+    Serial.flush();
+    if (Serial.begin(config.BAUD) != config.BAUD) {
+      Serial.print("# ");
+      Serial.print(config.BAUD);
+      Serial.print(" baud not supported, staying at ");
+      Serial.println(Serial.baud());
+    }
+  }
   MODE = config.MODE;
 
   CLOCK_HZ = config.CLOCK_HZ;
@@ -281,26 +494,39 @@ void ticc_setup() {
   CAL_PERIODS = config.CAL_PERIODS;
   WRAP = config.WRAP;
   ticksPerSecond = PS_PER_SEC / PICTICK_PS;
+  pictick_us = (PICTICK_PS % 1000000 == 0) ? (int32_t)(PICTICK_PS / 1000000) : 0;
+  clock_per_us = (1000000 % CLOCK_PERIOD == 0) ? (uint32_t)(1000000 / CLOCK_PERIOD) : 0;
+  default_timebase = (CLOCK_HZ == DEFAULT_CLOCK_HZ) && (PICTICK_PS == DEFAULT_PICTICK_PS);
 
   for (i = 0; i < ARRAY_SIZE(channels); ++i) {
     // initialize the channels struct variables
     channels[i].totalize = 0;
+    channels[i].timeouts = 0;
     channels[i].PICstop = 0;
+    channels[i].PICstop_latched = 0;
     channels[i].tof = 0;
 
     channels[i].name = config.NAME[i];
-    channels[i].prop_delay = config.PROP_DELAY[i];
+    channels[i].start_edge = config.START_EDGE[i];
     channels[i].time_dilation = config.TIME_DILATION[i];
     channels[i].fixed_time2 = config.FIXED_TIME2[i];
-    // For user convenience, we allow two settings that additively determine delay
-    channels[i].fudge = config.PROP_DELAY[i] + config.FUDGE0[i];
+    // For user convenience, we allow two settings that together determine delay
+    channels[i].set_offset(config.PROP_DELAY[i], config.FUDGE0[i]);
     // Initialize coarse-time cache (always enabled)
     channels[i].last_picstop = 0;
     channels[i].cached_sec = 0;
     channels[i].cached_rem_ticks = 0;
+    channels[i].reset_cal();       // first event reads and seeds calibration
+    channels[i].lsb_cal_diff = 0;  // forces fixed-point LSB rebuild on first event
+    channels[i].lsb_q24 = 0;
+
+  }
+  build_tags();
 
-    // set up the chips
-    channels[i].tdc_setup();
+  // set up the chips together: one ENABLE pulse, one LDO settle, one
+  // phase alignment for all of them
+  tdc_setup_all(channels, ARRAY_SIZE(channels));
+  for (i = 0; i < ARRAY_SIZE(channels); ++i) {
     channels[i].ready_next();
   }
 
@@ -308,10 +534,10 @@ void ticc_setup() {
    * Synchronize multiple TICCs sharing common 10 MHz and 10 kHz clocks.
   *******************************************/
   if (config.SYNC_MODE == 'M') {                  // if we are master, send sync by sending CLIENT_SYNC (A8) high
-    delay(2000);                                  // but first sleep to allow client boards to get ready
+    if (!warm) delay(2000);                       // but first sleep to allow client boards to get ready
     pinMode(CLIENT_SYNC, OUTPUT);                 // set CLIENT_SYNC as output (defaults to input)
     digitalWrite(CLIENT_SYNC, LOW);               // make sure it's low
-    delay(1000);                                  // wait a bit in case other boards need to catch up
+    if (!warm) delay(1000);                       // wait a bit in case other boards need to catch up
     last_pin = digitalRead(COARSEint);            // get current state of COARSE_CLOCK
     while (digitalRead(COARSEint) == last_pin) {  // loop until COARSE_CLOCK changes
       delayMicroseconds(5);                       // wait a bit
@@ -363,21 +589,67 @@ void ticc_setup() {
       Serial.println(" decimal places)");
       break;
     case Debug:
-      Serial.println("# time1 time2 clock1 cal1 cal2 PICstop tof timestamp");
+      Serial.println("# time1 time2 clock1 cal1 cal2 cal_fresh spi_xfers PICstop tof timestamp");
       break;
     case Null:
       Serial.println("# null output mode - no data");
       break;
+    case Raw:
+      Serial.println("# raw binary records follow (layout in tdc7200.h)");
+      break;
+    case Frequency:
+      if (config.FREQ_NOMINAL) {
+        Serial.print("# fractional frequency offset from ");
+        Serial.print(config.FREQ_NOMINAL);
+        Serial.print(" Hz");
+      } else {
+        Serial.print("# frequency (Hz with ");
+        Serial.print(config.PLACES);
+        Serial.print(" decimal places)");
+      }
+      Serial.print(", events, least squares per ");
+      Serial.print(config.FREQ_GATE);
+      Serial.println(" ticks");
+      break;
+    case Histogram:
+      Serial.print("# histogram of time interval A->B: ");
+      Serial.print(HIST_BINS);
+      Serial.print(" bins of ");
+      Serial.print(config.HIST_WIDTH);
+      Serial.print(" ps from ");
+      print_int64(config.HIST_LO);
+      Serial.println(" ps");
+      Serial.println("# <bin> <8 counts> H(A->B) per group in use, then <pairs> <under> <over> H(A->B)");
+      break;
   }  // switch
+  bool aggregating = (config.AGGREGATE != 'O') &&
+                     ((config.MODE == Interval) || (config.MODE == Period));
+  if (aggregating) {
+    Serial.print("# mean sd min max count, per ");
+    Serial.print(config.AGG_GATE);
+    Serial.println((config.AGGREGATE == 'T') ? " ticks" : " events");
+  } else if ((config.FORMAT != 'A') &&
+      ((config.MODE == Timestamp) || (config.MODE == Interval) ||
+       (config.MODE == Period) || (config.MODE == timeLab))) {
+    Serial.println("# binary COBS frames follow (layout in misc.h)");
+  }
+  if (config.SEQUENCE == 'Y') {
+    Serial.println("# data lines end with the event count; losses in '# overrun' lines");
+  }
 
 
   // turn the LEDs off
-  CLR_LED_0;
-  CLR_EXT_LED_0;
-  CLR_LED_1;
-  CLR_EXT_LED_1;
+  for (i = 0; i < NUM_CHANNELS; ++i) CLR_CH_LED(ch_led_mask[i]);
   CLR_EXT_LED_CLK;
 
+  // start the drop counters from zero with an empty TX ring
+  out_reset();
+  deltaReset();
+  agg_reset();
+  adev_reset();
+  freq_reset();
+  hist_reset();
+
 }  // ticc_setup
 
 /****************************************************************/
@@ -386,11 +658,15 @@ void loop() {
   ticc_setup();  // initialize and optionally go to config
 
   while (1) {
-    if ( (Serial.read() == '#') ) {        // direct entry to config menu
+    int c = Serial.read();
+    if (c == '#') {                        // direct entry to config menu
       // Set flag to enter config at end of current loop iteration
       config_requested = 1;
       // Clear any remaining characters from the serial buffer (like the <enter> from "#<enter>")
       while (Serial.available()) (void)Serial.read();
+    } else if (c == '?') {
+      if (config.ADEV != 'O') adev_report();         // deviation table on request
+      if (config.MODE == Histogram) hist_report();   // histogram so far
     }
 
     // Ref Clock indicator:
@@ -414,6 +690,8 @@ void loop() {
         } else {
           if (ext_clk_led_on) {  // turn off only if was on
             CLR_EXT_LED_CLK;
+            deltaPoll(true);
+            out_flush();
             Serial.println("# 10 MHZ Reference lost!");
             Serial.println("# Press any key to restart after reference is restored.");
             ext_clk_led_on = 0;
@@ -428,75 +706,83 @@ void loop() {
 
 
     size_t i;
+    uint8_t fetched = 0;  // bit i set if channel i was fetched this pass
+
+    // Pass 1: SPI only.  Fetch the raw registers from every chip that has
+    // finished and re-arm it straight away, so when A and B complete
+    // together the second chip isn't kept waiting on the first one's math
+    // and output.  The math below overlaps both next measurement windows.
     for (i = 0; i < ARRAY_SIZE(channels); ++i) {
 
       // No work to do unless intb is low
       if (digitalRead(channels[i].INTB) == 0) {
         // turn LED on -- use board.h macro for speed
-        if (i == 0) {
-          SET_LED_0;
-          SET_EXT_LED_0;
-        };
-        if (i == 1) {
-          SET_LED_1;
-          SET_EXT_LED_1;
-        };
+        SET_CH_LED(ch_led_mask[i]);
+
+        if (channels[i].fetch()) {   // SPI reads, latch PICstop, clear INTB
+          fetched |= (uint8_t)(1 << i);
+        } else {
+          // Counter overflow (missed STOP): no result; fetch() counted it
+          // in timeouts, so it still takes a sequence number (seq()) and
+          // shows as a gap.  totalize counts completed events only.
+          if (config.MODE == Raw) {
+            byte rec[RAW_RECORD_MAX];
+            out_record((uint8_t)i, rec, channels[i].raw_timeout(rec, (uint8_t)i));
+          } else if (config.MODE == Debug) {
+            LineRecord<LINE_DATA_MAX> r;   // "# chA timeout (N)"
+            r.put('#');
+            r.put(ch_tag[i], REC_CH_TAG_LEN);
+            r.put(" timeout (", 10);
+            r.put_dec(channels[i].timeouts);
+            r.put(')');
+            r.send(OUT_NO_CHANNEL);
+          }
+          CLR_CH_LED(ch_led_mask[i]);
+        }
+        channels[i].ready_next();  // Re-arm for next measurement
+      }
+    }
+
+    // Pass 2: timestamp math and output for the channels fetched above
+    for (i = 0; i < ARRAY_SIZE(channels); ++i) {
+
+      if (fetched & (1 << i)) {
+
+        // Raw mode: ship the registers and let the host do the math
+        if (config.MODE == Raw) {
+          byte rec[RAW_RECORD_MAX];
+          out_record((uint8_t)i, rec, channels[i].raw_record(rec, (uint8_t)i));
+          channels[i].totalize++;
+          CLR_CH_LED(ch_led_mask[i]);
+          continue;
+        }
 
         /* See the top-of-file rationale block for details on timestamp math,
          * signed 64-bit usage, overflow considerations, and formatting. */
 
-        channels[i].last_tof = channels[i].tof;  // preserve last value
         channels[i].last_ts_split = channels[i].ts_split;
-        channels[i].tof = channels[i].read();  // get data from chip
-
-        // Derive coarse seconds and remainder ticks using incremental method
-        // Incremental coarse-time decomposition to avoid 64-bit div/mod per hit
-        // Assumption: at most one second of ticks elapsed since last sample.
-        // We handle a single carry into seconds when delta ≤ ticksPerSecond.
-        // If delta is negative or requires more than one carry (delta > ticksPerSecond),
-        // the incremental state (cached_sec/cached_rem_ticks) would drift, so we realign
-        // by recomputing sec and remainder directly from PICstop (fallback path below).
-        int64_t sec;
-        int32_t remTicks32;
-        int64_t delta = channels[i].PICstop - channels[i].last_picstop;
-        channels[i].last_picstop = channels[i].PICstop;
-        if (delta >= 0 && delta <= ticksPerSecond) {
-          int32_t rem = channels[i].cached_rem_ticks + (int32_t)delta;
-          if (rem >= (int32_t)ticksPerSecond) {
-            rem -= (int32_t)ticksPerSecond;
-            channels[i].cached_sec++;
-          }
-          channels[i].cached_rem_ticks = rem;
-        } else {
-          // Fallback for startup/large jumps: recompute from absolute PICstop
-          channels[i].cached_sec = (int32_t)(channels[i].PICstop / ticksPerSecond);
-          channels[i].cached_rem_ticks = (int32_t)(channels[i].PICstop % ticksPerSecond);
-        }
-        sec = channels[i].cached_sec;
-        remTicks32 = channels[i].cached_rem_ticks;
-
-        // Original ps-path: compute remPs and subtract in ps
-        int64_t remPs = (int64_t)remTicks32 * PICTICK_PS;
-        // Subtract fine time-of-flight with borrow if needed
-        if (remPs >= channels[i].tof) {
-          remPs -= channels[i].tof;
-        } else {
-          remPs = (remPs + PS_PER_SEC) - channels[i].tof;
-          sec -= 1;
-        }
-        // Subtract propagation delay similarly
-        if (remPs >= channels[i].prop_delay) {
-          remPs -= channels[i].prop_delay;
+        channels[i].compute_tof_split();
+
+        if (default_timebase) {
+          stamp_channel<DefaultTimebase>(channels[i]);
         } else {
-          remPs = (remPs + PS_PER_SEC) - channels[i].prop_delay;
-          sec -= 1;
+          stamp_channel<ConfigTimebase>(channels[i]);
         }
-        channels[i].ts_split.sec = (int32_t)sec;
-        channels[i].ts_split.frac_hi = (uint32_t)(remPs / 1000000LL);
-        channels[i].ts_split.frac_lo = (uint32_t)(remPs % 1000000LL);
         channels[i].new_ts_ready = 1;
         channels[i].totalize++;    // increment number of events
-        channels[i].ready_next();  // Re-arm for next measurement, clear TDC INTB
+
+        // Frequency fits every event, indexed by seq() so that gaps
+        // from timeouts don't skew the slope; POLL_CHAR doesn't gate it
+        if ((config.MODE == Frequency) && (channels[i].totalize > 2)) {
+          FreqResult fr;
+          if (freq_add((uint8_t)i, channels[i].ts_split, channels[i].PICstop_latched,
+                       channels[i].seq(), &fr)) {
+            LineRecord<LINE_DATA_MAX> r;
+            r.grow(formatFrequency(r.end(), r.room(), fr, config.PLACES, config.FREQ_NOMINAL));
+            r.put(ch_tag[i], REC_CH_TAG_LEN);
+            r.send((uint8_t)i);
+          }
+        }
 
         // if poll character is not null, only output if we've received that character via serial
         // NOTE: this may provide random results if measuring timestamp from both channels!
@@ -510,17 +796,29 @@ void loop() {
               break;
 
             case Interval:
+            case Histogram:
               // handled after channel loop (pairing logic)
               break;
 
             case Period:
               {
                 SplitTime p = diffSplit(channels[i].ts_split, channels[i].last_ts_split);
-                char line[64];
-                size_t n = 0;
-                n = formatTimeDifference(line, sizeof(line), p, config.PLACES);
-                n += sprintf(line + n, " ch%c", (char)channels[i].name);
-                writeln64(line, n);
+                if (config.AGGREGATE != 'O') {
+                  AggStats st;
+                  if (agg_add((uint8_t)i, p, channels[i].PICstop_latched, &st)) {
+                    write_aggregate(st, (uint8_t)i, ch_tag[i], REC_CH_TAG_LEN);
+                  }
+                  break;
+                }
+                if (config.FORMAT != 'A') {
+                  writeBinary(BIN_TYPE_PERIOD, (uint8_t)i, (uint16_t)channels[i].seq(), p);
+                  break;
+                }
+                LineRecord<LINE_DATA_MAX> r;
+                r.grow(formatTimeDifference(r.end(), r.room(), p, config.PLACES));
+                r.put(ch_tag[i], REC_CH_TAG_LEN);
+                put_seq(r, channels[i].seq());
+                r.send((uint8_t)i);
               }
               break;
 
@@ -530,44 +828,41 @@ void loop() {
 
             case Debug:
               {
-                char line[128];
-                size_t n = 0;
+                LineRecord<LINE_DEBUG_MAX> r;
                 
-                // Raw TDC7200 values (6 digits each)
-                n += sprintf(line + n, "%06lu ", (unsigned long)channels[i].time1Result);
-                n += sprintf(line + n, "%06lu ", (unsigned long)channels[i].time2Result);
-                n += sprintf(line + n, "%06lu ", (unsigned long)channels[i].clock1Result);
-                n += sprintf(line + n, "%06lu ", (unsigned long)channels[i].cal1Result);
-                n += sprintf(line + n, "%06lu ", (unsigned long)channels[i].cal2Result);
+                // Raw TDC7200 values (at least 6 digits each)
+                r.put_dec(channels[i].time1Result, 6);  r.put(' ');
+                r.put_dec(channels[i].time2Result, 6);  r.put(' ');
+                r.put_dec(channels[i].clock1Result, 6); r.put(' ');
+                r.put_dec(channels[i].cal1Result, 6);   r.put(' ');
+                r.put_dec(channels[i].cal2Result, 6);   r.put(' ');
+                // 1 if cal1/cal2 were read for this event, 0 if they are
+                // held from an earlier one (CAL_REFRESH > 1)
+                r.put(channels[i].cal_fresh ? '1' : '0'); r.put(' ');
+                r.put_dec(channels[i].spi_xfers);       r.put(' ');  // fetch + re-arm
                 
-                // PICstop (int64_t - need special handling)
-                char pic_buf[32];
-                size_t pic_len = format_int64_to_buffer(pic_buf, sizeof(pic_buf), channels[i].PICstop);
-                memcpy(line + n, pic_buf, pic_len);
-                n += pic_len;
-                line[n++] = ' ';
-                
-                // tof (int64_t - need special handling) 
-                char tof_buf[32];
-                size_t tof_len = format_int64_to_buffer(tof_buf, sizeof(tof_buf), channels[i].tof);
-                memcpy(line + n, tof_buf, tof_len);
-                n += tof_len;
-                line[n++] = ' ';
+                // PICstop and tof (int64_t - need special handling)
+                r.grow(format_int64_to_buffer(r.end(), r.room(), channels[i].PICstop_latched));
+                r.put(' ');
+                r.grow(format_int64_to_buffer(r.end(), r.room(), channels[i].tof_ps()));
+                r.put(' ');
                 
                 // timestamp (SplitTime - use existing function)
-                char ts_buf[32];
-                size_t ts_len = formatTimestampSplitTo(ts_buf, sizeof(ts_buf), channels[i].ts_split, config.PLACES, WRAP);
-                memcpy(line + n, ts_buf, ts_len);
-                n += ts_len;
+                r.grow(formatTimestampSplitTo(r.end(), r.room(), channels[i].ts_split, config.PLACES, WRAP));
                 
                 // Channel name
-                n += sprintf(line + n, " ch%c", (char)channels[i].name);
-                
-                writeln64(line, n);
+                r.put(ch_tag[i], REC_CH_TAG_LEN);
+                put_seq(r, channels[i].seq());
+                r.send((uint8_t)i);
               }
               break;
 
+            case Frequency:
+              // handled above: every event goes into the fit
+              break;
+
             case Null:
+            case Raw:
               break;
           }  // switch
 
@@ -575,16 +870,9 @@ void loop() {
         }  // print result
 
         // turn LED off
-        if (i == 0) {
-          CLR_LED_0;
-          CLR_EXT_LED_0;
-        };
-        if (i == 1) {
-          CLR_LED_1;
-          CLR_EXT_LED_1;
-        };
-
-      }  // if INTB
+        CLR_CH_LED(ch_led_mask[i]);
+
+      }  // if fetched
     }    // for
 
     // Timestamp mode: assemble and print pairs without timeout
@@ -596,16 +884,18 @@ void loop() {
       struct PairSlot {
         SplitTime t;
         uint8_t ch;
+        uint32_t seq;  // seq() when stamped, for sequence tags and binary records
       };
       static PairSlot ts_pair[2];
       static uint8_t ts_pair_count = 0;
 
       // Ingest any fresh samples into the pair buffer
-      for (int ci = 0; ci < 2; ++ci) {
+      for (size_t ci = 0; ci < NUM_CHANNELS; ++ci) {
         if (channels[ci].new_ts_ready && (channels[ci].totalize > 2)) {
           if (ts_pair_count < 2) {
             ts_pair[ts_pair_count].t = channels[ci].ts_split;
             ts_pair[ts_pair_count].ch = (uint8_t)ci;
+            ts_pair[ts_pair_count].seq = (uint32_t)channels[ci].seq();
             ts_pair_count++;
           }
           channels[ci].new_ts_ready = 0;  // consume
@@ -619,119 +909,163 @@ void loop() {
           if ((Serial.available() > 0) && (Serial.read() == config.POLL_CHAR)) ok = true;
         }
         if (ok) {
-          // Determine composition and enforce chA then chB order when both present
-          if ((ts_pair[0].ch == 0 && ts_pair[1].ch == 1) || (ts_pair[0].ch == 1 && ts_pair[1].ch == 0)) {
-            // Mixed channels: find A then B
-            const PairSlot *A = (ts_pair[0].ch == 0) ? &ts_pair[0] : &ts_pair[1];
-            const PairSlot *B = (ts_pair[0].ch == 1) ? &ts_pair[0] : &ts_pair[1];
-            {
-              char line[64];
-              size_t n = formatTimestampSplitTo(line, sizeof(line), A->t, config.PLACES, WRAP);
-              n += sprintf(line + n, " ch%c", (char)channels[0].name);
-              writeln64(line, n);
-            }
-            {
-              char line[64];
-              size_t n = formatTimestampSplitTo(line, sizeof(line), B->t, config.PLACES, WRAP);
-              n += sprintf(line + n, " ch%c", (char)channels[1].name);
-              writeln64(line, n);
+          // Lower-numbered channel first when the pair is mixed (chA then
+          // chB); the same channel twice prints in arrival order
+          uint8_t first = (ts_pair[1].ch < ts_pair[0].ch) ? 1 : 0;
+          for (int k = 0; k < 2; ++k) {
+            const PairSlot *ps = &ts_pair[first ^ k];
+            if (config.FORMAT == 'D') {
+              writeDelta(ps->ch, (uint16_t)ps->seq, ps->t);
+              continue;
             }
-          } else {
-            // Same channel twice: print both with that channel's name
-            uint8_t ci = ts_pair[0].ch;
-            char cname = channels[ci].name;
-            for (int k = 0; k < 2; ++k) {
-              char line[64];
-              size_t n = formatTimestampSplitTo(line, sizeof(line), ts_pair[k].t, config.PLACES, WRAP);
-              n += sprintf(line + n, " ch%c", cname);
-              writeln64(line, n);
+            if (config.FORMAT == 'B') {
+              writeBinary(BIN_TYPE_TIMESTAMP, ps->ch, (uint16_t)ps->seq, ps->t);
+              continue;
             }
+            LineRecord<LINE_DATA_MAX> r;
+            r.grow(formatTimestampSplitTo(r.end(), r.room(), ps->t, config.PLACES, WRAP));
+            r.put(ch_tag[ps->ch], REC_CH_TAG_LEN);
+            put_seq(r, ps->seq);
+            r.send(ps->ch);
           }
           ts_pair_count = 0;  // clear pair buffer after printing
         }
       }
     }
 
-    // After processing both channels, pair and print once per matched sample for Interval and TimeLab
-    if ((channels[0].new_ts_ready && channels[1].new_ts_ready) && (channels[0].totalize > 2) && (channels[1].totalize > 2)) {
-      // Optional poll gating
-      bool ok = (!config.POLL_CHAR);
-      if (!ok) {
-        if ((Serial.available() > 0) && (Serial.read() == config.POLL_CHAR)) ok = true;
-      }
-      if (ok) {
-        switch (config.MODE) {
-          case Interval:
-            {
-              SplitTime d = diffSplit(channels[1].ts_split, channels[0].ts_split);
+    // After processing all channels, pair and print once per matched sample for
+    // Interval and TimeLab.  Channels pair up as (0,1), (2,3), ...; TimeLab's
+    // synthesized third channel only makes sense for the first pair.
+    for (size_t p = 0; p + 1 < NUM_CHANNELS; p += 2) {
+      tdc7200Channel &a = channels[p];
+      tdc7200Channel &b = channels[p + 1];
+      if ((a.new_ts_ready && b.new_ts_ready) && (a.totalize > 2) && (b.totalize > 2)) {
+        // Optional poll gating
+        bool ok = (!config.POLL_CHAR);
+        if (!ok) {
+          if ((Serial.available() > 0) && (Serial.read() == config.POLL_CHAR)) ok = true;
+        }
+        if (ok) {
+          // A->B is the phase for the stability table
+          if ((p == 0) && ((config.MODE == Interval) || (config.MODE == timeLab))) {
+            adev_add(diffSplit(b.ts_split, a.ts_split), b.ts_split);
+          }
+          switch (config.MODE) {
+            case Interval:
               {
-                char line[64];
-                size_t n = formatTimeDifference(line, sizeof(line), d, config.PLACES);
-                n += sprintf(line + n, " TI(A->B)");
-                writeln64(line, n);
+                SplitTime d = diffSplit(b.ts_split, a.ts_split);
+                AggStats st;
+                if (config.AGGREGATE != 'O') {
+                  if (agg_add((uint8_t)p, d, b.PICstop_latched, &st)) {
+                    write_aggregate(st, (uint8_t)p, ti_tag[p / 2], REC_TI_TAG_LEN);
+                  }
+                } else if (config.FORMAT != 'A') {
+                  writeBinary(BIN_TYPE_INTERVAL, (uint8_t)p, (uint16_t)b.seq(), d);
+                } else {
+                  LineRecord<LINE_DATA_MAX> r;
+                  r.grow(formatTimeDifference(r.end(), r.room(), d, config.PLACES));
+                  r.put(ti_tag[p / 2], REC_TI_TAG_LEN);
+                  put_seq(r, b.seq());
+                  r.send((uint8_t)p);
+                }
+                a.new_ts_ready = 0;
+                b.new_ts_ready = 0;
+                break;
               }
-              channels[0].new_ts_ready = 0;
-              channels[1].new_ts_ready = 0;
+            case Histogram:
+              if (p == 0) hist_add(diffSplit(b.ts_split, a.ts_split));
+              a.new_ts_ready = 0;
+              b.new_ts_ready = 0;
               break;
-            }
-          case timeLab:
-            {
+            case timeLab:
+              if (p != 0) break;
+              if (config.FORMAT != 'A') {
+                // chC is int(B) + (B - A) in text; the interval record
+                // carries the same information
+                writeBinary(BIN_TYPE_TIMESTAMP, 0, (uint16_t)a.seq(), a.ts_split);
+                writeBinary(BIN_TYPE_TIMESTAMP, 1, (uint16_t)b.seq(), b.ts_split);
+                writeBinary(BIN_TYPE_INTERVAL, 0, (uint16_t)b.seq(), diffSplit(b.ts_split, a.ts_split));
+                a.new_ts_ready = 0;
+                b.new_ts_ready = 0;
+                break;
+              }
               {
-                char line[64];
-                size_t n;
-                // chA
-                n = formatTimestampSplitTo(line, sizeof(line), channels[0].ts_split, config.PLACES, WRAP);
-                n += sprintf(line + n, " ch%c", (char)channels[0].name);
-                writeln64(line, n);
-                // chB
-                n = formatTimestampSplitTo(line, sizeof(line), channels[1].ts_split, config.PLACES, WRAP);
-                n += sprintf(line + n, " ch%c", (char)channels[1].name);
-                writeln64(line, n);
-                // chC synthesized = int(chB) + (chB - chA) - properly handle negative differences
-                SplitTime d = diffSplit(channels[1].ts_split, channels[0].ts_split);
-                SplitTime c;
+                {
+                  // chA
+                  {
+                    LineRecord<LINE_DATA_MAX> r;
+                    r.grow(formatTimestampSplitTo(r.end(), r.room(), a.ts_split, config.PLACES, WRAP));
+                    r.put(ch_tag[0], REC_CH_TAG_LEN);
+                    put_seq(r, a.seq());
+                    r.send(0);
+                  }
+                  // chB
+                  {
+                    LineRecord<LINE_DATA_MAX> r;
+                    r.grow(formatTimestampSplitTo(r.end(), r.room(), b.ts_split, config.PLACES, WRAP));
+                    r.put(ch_tag[1], REC_CH_TAG_LEN);
+                    put_seq(r, b.seq());
+                    r.send(1);
+                  }
+                  // chC synthesized = int(chB) + (chB - chA) - properly handle negative differences
+                  SplitTime d = diffSplit(b.ts_split, a.ts_split);
+                  SplitTime c;
                 
-                // Synthesize chC = int(chB) + (chB - chA)
-                // chC uses the integer seconds from chB, plus the fractional difference
-                c.sec = channels[1].ts_split.sec;  // int(chB) - integer seconds from chB
-                c.frac_hi = d.frac_hi;             // (chB - chA) fractional part
-                c.frac_lo = d.frac_lo;             // (chB - chA) fractional part
+                  // Synthesize chC = int(chB) + (chB - chA)
+                  // chC uses the integer seconds from chB, plus the fractional difference
+                  c.sec = b.ts_split.sec;  // int(chB) - integer seconds from chB
+                  c.frac_hi = d.frac_hi;             // (chB - chA) fractional part
+                  c.frac_lo = d.frac_lo;             // (chB - chA) fractional part
                 
-                // Handle negative fractional differences (d.sec < 0 means negative difference)
-                if (d.sec < 0) {
-                  // The fractional part is in complement representation, convert to normal
-                  if (d.frac_hi != 0 || d.frac_lo != 0) {
-                    c.frac_lo = 1000000UL - d.frac_lo;
-                    c.frac_hi = (d.frac_hi == 0) ? 999999UL : (1000000UL - d.frac_hi - 1UL);
-                    // Since we're subtracting from the integer seconds, borrow if needed
-                    if (c.frac_lo >= 1000000) {
-                      c.frac_lo -= 1000000;
-                      c.frac_hi += 1;
-                    }
-                    if (c.frac_hi >= 1000000) {
-                      c.frac_hi -= 1000000;
-                      c.sec += 1;
+                  // Handle negative fractional differences (d.sec < 0 means negative difference)
+                  if (d.sec < 0) {
+                    // The fractional part is in complement representation, convert to normal
+                    if (d.frac_hi != 0 || d.frac_lo != 0) {
+                      c.frac_lo = 1000000UL - d.frac_lo;
+                      c.frac_hi = (d.frac_hi == 0) ? 999999UL : (1000000UL - d.frac_hi - 1UL);
+                      // Since we're subtracting from the integer seconds, borrow if needed
+                      if (c.frac_lo >= 1000000) {
+                        c.frac_lo -= 1000000;
+                        c.frac_hi += 1;
+                      }
+                      if (c.frac_hi >= 1000000) {
+                        c.frac_hi -= 1000000;
+                        c.sec += 1;
+                      }
                     }
                   }
-                }
                 
-                n = formatTimestampSplitTo(line, sizeof(line), c, config.PLACES, WRAP);
-                n += sprintf(line + n, " chC (int(B) + (B - A))");
-                writeln64(line, n);
+                  static const char chc_tag[] = " chC (int(B) + (B - A))";
+                  LineRecord<LINE_DATA_MAX> r;
+                  r.grow(formatTimestampSplitTo(r.end(), r.room(), c, config.PLACES, WRAP));
+                  r.put(chc_tag, sizeof(chc_tag) - 1);
+                  put_seq(r, b.seq());
+                  r.send(1);
+                }
+                a.new_ts_ready = 0;
+                b.new_ts_ready = 0;
+                break;
               }
-              channels[0].new_ts_ready = 0;
-              channels[1].new_ts_ready = 0;
-              break;
-            }
-          default: break;
+            default: break;
+          }
         }
       }
     }
 
+    // Send delta frames that have waited long enough, and report
+    // records lost to the overload policy, if any
+    if (config.FORMAT == 'D') deltaPoll(false);
+    out_report(channel_timeouts);
+    adev_poll();
+
     // Check if config was requested during this loop iteration
     if (config_requested) {
       config_requested = 0;  // Clear the flag
       
+      // Let queued records out ahead of the direct Serial output below
+      deltaPoll(true);
+      out_flush();
+
       // Stop TDC7200 measurements to prevent new data during config
       Serial.println("# Stopping measurements for config...");
       stop_all_measurements();
@@ -741,11 +1075,8 @@ void loop() {
       Serial.println("# Flushing pending measurements before config...");
       flush_all_channels();
       
-      // Small delay to ensure buffer is fully cleared
-      delay(10);
-      
-      // Double-check buffer is clear
-      while (Serial.available()) (void)Serial.read();
+      // Clear the rest of the "#<enter>" line from the serial buffer
+      drain_serial_input();
       
       // Backup config before making changes
       backup_config();
@@ -774,6 +1105,11 @@ void loop() {
       
       // Restart measurements after config changes
       Serial.println("# Restarting measurements...");
+      out_flush();
+      agg_reset();
+      adev_reset();
+      freq_reset();
+      hist_reset();
       start_all_measurements();
       
       // Clear the config_changed flag for next time
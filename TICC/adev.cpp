@@ -0,0 +1,135 @@
+// adev.cpp -- streaming Allan and modified Allan deviation
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"           // config and eeprom
+#include "misc.h"             // SplitTime and U128 helpers
+#include "adev.h"
+#include "uart0.h"            // USART0 driver; remaps Serial
+#include "output.h"           // record output and overload policy
+
+extern config_t config;
+
+// Phases and sums are ps relative to the first sample
+struct AdevLevel {
+  int64_t x1, x2;             // phase at the last two multiples of 2^k
+  int64_t s1, s2;             // sums of the last two complete 2^k blocks
+  int64_t pend;               // first half of the next block (from level k - 1)
+  U128    acc_a;              // sum of (x2 - 2 x1 + x0)^2
+  U128    acc_m;              // sum of (s2 - 2 s1 + s0)^2
+};
+static AdevLevel lev[ADEV_LEVELS];
+static SplitTime x_ref;
+static SplitTime t_first, t_last;
+static uint32_t samples;
+static uint32_t last_report_ms;
+
+void adev_reset() {
+  memset(lev, 0, sizeof(lev));
+  samples = 0;
+  last_report_ms = millis();
+}
+
+static void accumulate(U128 *acc, int64_t d) {
+  uint64_t m = (d < 0) ? (uint64_t)-d : (uint64_t)d;
+  u128_add(acc, u128_mul64(m, m));
+}
+
+void adev_add(const SplitTime &x, const SplitTime &t) {
+  if (config.ADEV == 'O') return;
+  if (!samples) {
+    x_ref = x;
+    t_first = t;
+  }
+  t_last = t;
+  int64_t v = splitToPs(diffSplit(x, x_ref));
+  uint32_t i = samples++;
+
+  // ADEV: every level whose decimation step divides i
+  for (uint8_t k = 0; k < ADEV_LEVELS; ++k) {
+    if (i & ((1UL << k) - 1)) break;
+    AdevLevel &l = lev[k];
+    if ((i >> k) >= 2) accumulate(&l.acc_a, v - 2 * l.x1 + l.x2);
+    l.x2 = l.x1;
+    l.x1 = v;
+  }
+
+  // MDEV: sample i ends a block at level k when 2^k divides i + 1; two
+  // blocks at level k make one at level k + 1
+  int64_t s = v;
+  for (uint8_t k = 0; k < ADEV_LEVELS; ++k) {
+    AdevLevel &l = lev[k];
+    uint32_t blocks = (i + 1) >> k;
+    if (blocks >= 3) accumulate(&l.acc_m, s - 2 * l.s1 + l.s2);
+    l.s2 = l.s1;
+    l.s1 = s;
+    if (k + 1 == ADEV_LEVELS) break;
+    if (blocks & 1) {
+      lev[k + 1].pend = s;
+      break;
+    }
+    s += lev[k + 1].pend;
+  }
+}
+
+// sqrt(acc / (2 terms) / 4^shift2) / tau into buf.  The root is taken
+// with as many fraction bits as acc and tau leave room for, so a
+// deviation of a few ps still gets four digits.
+static size_t format_dev(char *buf, const U128 &acc, uint32_t terms, uint8_t shift2,
+                         uint64_t tau) {
+  uint8_t fb = 30;
+  while (fb && ((tau >> (63 - fb)) || (acc.hi >> (63 - 2 * fb)))) fb--;
+  U128 v = u128_div64(u128_shl(acc, 2 * fb), 2ULL * terms);
+  v = u128_shr(v, 2 * shift2);
+  return formatSci(buf, u128_isqrt(v), tau << fb);
+}
+
+void adev_report() {
+  char line[64];
+  size_t n;
+
+  last_report_ms = millis();
+  if (samples < 3) {
+    n = sprintf(line, "# stability: %lu samples", (unsigned long)samples);
+    writeln(line, n, OUT_NO_CHANNEL);
+    return;
+  }
+  uint64_t tau0 = (uint64_t)splitToPs(diffSplit(t_last, t_first)) / (samples - 1);
+  if (!tau0) return;
+
+  n = sprintf(line, "# stability: %lu samples, tau0 ", (unsigned long)samples);
+  n += formatSci(line + n, tau0, 1000000000000ULL);
+  n += sprintf(line + n, " s");
+  writeln(line, n, OUT_NO_CHANNEL);
+
+  for (uint8_t k = 0; k < ADEV_LEVELS; ++k) {
+    uint32_t m = 1UL << k;
+    uint32_t a_terms = (samples - 1) / m + 1;
+    uint32_t m_terms = samples / m;
+    if (a_terms < 3) break;
+    a_terms -= 2;
+    m_terms = (m_terms >= 3) ? m_terms - 2 : 0;
+    n = sprintf(line, "# tau ");
+    n += formatSci(line + n, tau0 << k, 1000000000000ULL);
+    n += sprintf(line + n, " n %lu adev ", (unsigned long)a_terms);
+    n += format_dev(line + n, lev[k].acc_a, a_terms, 0, tau0 << k);
+    if (m_terms) {
+      n += sprintf(line + n, " mdev ");
+      n += format_dev(line + n, lev[k].acc_m, m_terms, k, tau0 << k);
+    }
+    writeln(line, n, OUT_NO_CHANNEL);
+  }
+}
+
+void adev_poll() {
+  if ((config.ADEV == 'P') && samples &&
+      ((millis() - last_report_ms) >= (uint32_t)config.ADEV_PERIOD * 1000UL)) {
+    adev_report();
+  }
+}
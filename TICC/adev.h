@@ -0,0 +1,43 @@
+#ifndef ADEV_H
+#define ADEV_H
+
+// adev.h -- streaming Allan and modified Allan deviation
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+// With config.ADEV set, the A->B interval of Interval and TimeLab modes
+// is taken as phase x, sampled once per event pair, and ADEV and MDEV
+// are kept for tau = 2^k tau0, k = 0 .. ADEV_LEVELS - 1.  tau0 is the
+// mean spacing of channel B's events.
+//
+// No phase history is stored.  Level k keeps the last two phases at
+// multiples of 2^k samples and the last two sums of 2^k-sample blocks,
+// built up from level k - 1, so the state is fixed and every level
+// costs O(1) per sample on average.  The price is that each tau is
+// estimated from samples 2^k apart (non-overlapping) rather than from
+// every sample, so the confidence at long tau is that of the
+// non-overlapping estimators.  Squared second differences are summed
+// exactly in 128 bits.
+//
+// adev_report() sends the table as '#' comment lines:
+//   # tau <s> n <terms> adev <x> mdev <x>
+// on '?' from the host ('R' and 'P') and every ADEV_PERIOD seconds ('P').
+
+#include <stdint.h>
+
+#ifndef ADEV_LEVELS
+#define ADEV_LEVELS  10       // tau0 .. 512 tau0; about 70 bytes each
+#endif
+
+// SplitTime comes from misc.h, which must be included first
+
+void adev_reset();
+// Add one phase sample x, taken with channel B's event at t
+void adev_add(const SplitTime &x, const SplitTime &t);
+void adev_report();
+void adev_poll();             // periodic report, if due
+
+#endif  /* ADEV_H */
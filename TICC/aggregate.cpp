@@ -0,0 +1,107 @@
+// aggregate.cpp -- on-board gate statistics for Period and Interval modes
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"           // config and eeprom
+#include "misc.h"             // SplitTime helpers
+#include "aggregate.h"
+
+extern config_t config;
+
+struct AggSlot {
+  SplitTime x0;               // gate's first value; the others are held as ps from it
+  int64_t   gate_start;       // coarse tick the gate opened at ('T')
+  int64_t   sum;              // sum of d
+  U128      sum2;             // sum of d * d
+  int64_t   dmin;
+  int64_t   dmax;
+  uint32_t  n;
+};
+static AggSlot slots[NUM_CHANNELS];
+
+static SplitTime plus_ps(const SplitTime &a, int64_t ps) {
+  SplitTime d = psToSplit(ps);
+  d.sec += a.sec;
+  d.frac_hi += a.frac_hi;
+  d.frac_lo += a.frac_lo;
+  normalizeSplit(&d);
+  return d;
+}
+
+void agg_reset() {
+  memset(slots, 0, sizeof(slots));
+}
+
+static void finish(AggSlot &s, AggStats *out) {
+  uint32_t n = s.n;
+  int64_t half = (s.sum < 0) ? -(int64_t)(n / 2) : (int64_t)(n / 2);
+  out->n = n;
+  out->mean = plus_ps(s.x0, (s.sum + half) / (int64_t)n);
+  out->min = plus_ps(s.x0, s.dmin);
+  out->max = plus_ps(s.x0, s.dmax);
+  out->sd = psToSplit(0);
+  if (n > 1) {
+    // n * sum2 - sum^2 is n(n - 1) times the sample variance
+    uint64_t m = (s.sum < 0) ? (uint64_t)-s.sum : (uint64_t)s.sum;
+    U128 v = u128_mul32(s.sum2, n);
+    u128_sub(&v, u128_mul64(m, m));
+    v = u128_div64(v, (uint64_t)n * (n - 1));
+    out->sd = psToSplit((int64_t)u128_isqrt(v));
+  }
+  s.n = 0;
+}
+
+bool agg_add(uint8_t slot, const SplitTime &v, int64_t tick, AggStats *done) {
+  AggSlot &s = slots[slot];
+  bool closed = false;
+
+  if ((config.AGGREGATE == 'T') && s.n && ((tick - s.gate_start) >= config.AGG_GATE)) {
+    finish(s, done);
+    closed = true;
+    s.gate_start += ((tick - s.gate_start) / config.AGG_GATE) * config.AGG_GATE;
+  }
+
+  int64_t d = 0;
+  if (!s.n) {
+    s.x0 = v;
+    s.sum = 0;
+    s.sum2.hi = 0;
+    s.sum2.lo = 0;
+    s.dmin = 0;
+    s.dmax = 0;
+    if (!closed) s.gate_start = tick;
+  } else {
+    d = splitToPs(diffSplit(v, s.x0));
+    uint64_t m = (d < 0) ? (uint64_t)-d : (uint64_t)d;
+    u128_add(&s.sum2, u128_mul64(m, m));
+    s.sum += d;
+    if (d < s.dmin) s.dmin = d;
+    if (d > s.dmax) s.dmax = d;
+  }
+  s.n++;
+
+  if ((config.AGGREGATE == 'N') && (s.n >= (uint32_t)config.AGG_GATE)) {
+    finish(s, done);
+    closed = true;
+  }
+  return closed;
+}
+
+size_t formatAggregate(char *buf, size_t cap, const AggStats &s, int places) {
+  size_t n = formatTimeDifference(buf, cap, s.mean, places);
+  buf[n++] = ' ';
+  n += formatTimeDifference(buf + n, cap - n, s.sd, places);
+  buf[n++] = ' ';
+  n += formatTimeDifference(buf + n, cap - n, s.min, places);
+  buf[n++] = ' ';
+  n += formatTimeDifference(buf + n, cap - n, s.max, places);
+  buf[n++] = ' ';
+  n += formatU32(buf + n, cap - n, s.n, 1);
+  return n;
+}
@@ -0,0 +1,42 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+// aggregate.h -- on-board gate statistics for Period and Interval modes
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+// With config.AGGREGATE set, Period and Interval results are not sent
+// one by one.  Each channel (Period) or pair (Interval) accumulates its
+// values over a gate of config.AGG_GATE events ('N') or coarse ticks
+// ('T') and one line goes out per gate:
+//   mean sd min max count chX          (or TI(A->B) for intervals)
+// The accumulators are exact: values are held as ps offsets from the
+// gate's first value, with a 64-bit sum and a 128-bit sum of squares,
+// so sd is floor(sqrt(sum of squared deviations / (n - 1))) to the ps.
+// A tick gate runs on the event times, so a gate with no events sends
+// nothing, and its line goes out with the first event past its end.
+
+#include <stdint.h>
+#include <stddef.h>
+
+// SplitTime comes from misc.h, which must be included first
+
+struct AggStats {
+  uint32_t  n;
+  SplitTime mean;             // rounded to the nearest ps
+  SplitTime sd;               // 0 when n < 2
+  SplitTime min;
+  SplitTime max;
+};
+
+void agg_reset();
+// Add slot's next value v, stamped at coarse tick tick.  Returns true
+// when that closed a gate, whose statistics are then in *done.
+bool agg_add(uint8_t slot, const SplitTime &v, int64_t tick, AggStats *done);
+// "mean sd min max count" with places decimals; returns bytes written
+size_t formatAggregate(char *buf, size_t cap, const AggStats &s, int places);
+
+#endif  /* AGGREGATE_H */
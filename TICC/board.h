@@ -43,6 +43,20 @@ const int EXT_LED_1 =   A13; // external LED tandem with LED_1 -- PORTK,5
 const int LED_0 =       A14; // onboard LED -- PORTK,6
 const int LED_1 =       A15; // onboard LED -- PORTK,7
 
+// Channel map: one CHANNEL_ENTRY(id, ENABLE, INTB, CSB, STOP, LED) per
+// TDC7200, in channel order.  A board with more chips sets NUM_CHANNELS
+// in config.h and adds its rows here.
+#if (NUM_CHANNELS == 2)
+#define CHANNEL_TABLE \
+  CHANNEL_ENTRY('0', ENABLE_0, INTB_0, CSB_0, STOP_0, LED_0), \
+  CHANNEL_ENTRY('1', ENABLE_1, INTB_1, CSB_1, STOP_1, LED_1)
+#define CHANNEL_EXT_LEDS  { EXT_LED_0, EXT_LED_1 }
+// PORTK bits for each channel's onboard + external LED pair
+#define CHANNEL_LED_MASKS { (1<<6)|(1<<4), (1<<7)|(1<<5) }
+#else
+#error "No channel pin map in board.h for this NUM_CHANNELS"
+#endif
+
 // These are macros to turn LEDs on and off really fast.
 // We trade flexibility for speed.
 
@@ -56,5 +70,7 @@ const int LED_1 =       A15; // onboard LED -- PORTK,7
 #define SET_EXT_LED_1 (PORTK|=(1<<5))
 #define CLR_EXT_LED_CLK (PORTK&=(~(1<<3)))
 #define SET_EXT_LED_CLK (PORTK|=(1<<3))
+#define CLR_CH_LED(mask) (PORTK&=(uint8_t)~(mask))
+#define SET_CH_LED(mask) (PORTK|=(mask))
 
 #endif	/* BOARD_H */
@@ -17,6 +17,8 @@
 #include "config.h"           // config and eeprom
 #include "board.h"            // Arduino pin definitions
 #include "tdc7200.h"          // TDC registers and structures
+#include "uart0.h"            // USART0 driver; remaps Serial
+#include "hist.h"             // HIST_BINS
 
 extern const char SW_VERSION[17]; // set in TICC.ino
 extern const char SW_TAG[6];      // set in TICC.ino
@@ -196,6 +198,58 @@ static bool parseDecimalScaledPair(const char *s, int64_t scale, bool *set0, int
   return true;
 }
 
+// Parse calibration filter syntax "F[/refresh[/drift]]", e.g. "I/16/20".
+// F is N, I or M; omitted numbers keep their current values.
+static bool parseCalFilter(const char *s, char *filter, int64_t *refresh, int64_t *drift) {
+  if (!s || !*s) return false;
+  char f = toupper(s[0]);
+  if (f != 'N' && f != 'I' && f != 'M') return false;
+  char tmp[64];
+  size_t l = strlcpy(tmp, s + 1, sizeof(tmp)); (void)l;
+  char *t = trimInPlace(tmp);
+  int64_t r = *refresh, d = *drift;
+  if (*t) {
+    if (*t != '/') return false;
+    t++;
+    char *slash = strchr(t, '/');
+    if (slash) *slash = '\0';
+    char *rs = trimInPlace(t);
+    if (*rs && (!parseInt64Simple(rs, &r) || r < 1 || r > 32767)) return false;
+    if (slash) {
+      char *ds = trimInPlace(slash + 1);
+      if (*ds && (!parseInt64Simple(ds, &d) || d < 0 || d > 32767)) return false;
+    }
+  }
+  *filter = f; *refresh = r; *drift = d;
+  return true;
+}
+
+// Parse timeout syntax "HH[/mode]", e.g. "05/A".  HH is the CLOCK_CNTR_OVF
+// high byte in hex (01..FF); mode is F(ixed) or A(daptive), kept if omitted.
+static bool parseTimeout(const char *s, int16_t *timeout, char *mode) {
+  if (!s || !*s) return false;
+  if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) s += 2;
+  int16_t v = 0; uint8_t digits = 0;
+  while (isxdigit(*s)) {
+    char c = toupper(*s++);
+    v = v * 16 + ((c <= '9') ? (c - '0') : (c - 'A' + 10));
+    if (++digits > 2) return false;
+  }
+  if (digits == 0 || v == 0) return false;
+  while (*s == ' ') s++;
+  char m = *mode;
+  if (*s == '/') {
+    s++; while (*s == ' ') s++;
+    m = toupper(*s);
+    if (m != 'F' && m != 'A') return false;
+    s++;
+  }
+  while (*s == ' ') s++;
+  if (*s) return false;
+  *timeout = v; *mode = m;
+  return true;
+}
+
 // Legacy input functions removed - replaced by readLine() in unified menu system
 
 // Legacy getInt64 function removed - replaced by parseInt64Simple() and parseDecimalScaled() in unified menu system
@@ -223,6 +277,9 @@ char modeToChar(unsigned char mode)
 			case Period:    return 'P';
 			case timeLab:   return 'L';
 			case Debug:     return 'D';
+			case Raw:       return 'R';
+			case Frequency: return 'F';
+			case Histogram: return 'H';
 		}
    return '?';
 }
@@ -239,9 +296,27 @@ struct config_t defaultConfig() {
   x.PICTICK_PS = DEFAULT_PICTICK_PS;
   x.CAL_PERIODS = DEFAULT_CAL_PERIODS;
   x.TIMEOUT = DEFAULT_TIMEOUT;
+  x.TIMEOUT_MODE = DEFAULT_TIMEOUT_MODE;
   x.WRAP = DEFAULT_WRAP;
   x.PLACES = DEFAULT_PLACES;
   x.SYNC_MODE = DEFAULT_SYNC_MODE;
+  x.CAL_FILTER = DEFAULT_CAL_FILTER;
+  x.CAL_REFRESH = DEFAULT_CAL_REFRESH;
+  x.CAL_DRIFT = DEFAULT_CAL_DRIFT;
+  x.FORMAT = DEFAULT_FORMAT;
+  x.BAUD = DEFAULT_BAUD;
+  x.OVERLOAD = DEFAULT_OVERLOAD;
+  x.OVERLOAD_N = DEFAULT_OVERLOAD_N;
+  x.AGGREGATE = DEFAULT_AGGREGATE;
+  x.AGG_GATE = DEFAULT_AGG_GATE;
+  x.ADEV = DEFAULT_ADEV;
+  x.ADEV_PERIOD = DEFAULT_ADEV_PERIOD;
+  x.FREQ_GATE = DEFAULT_FREQ_GATE;
+  x.FREQ_NOMINAL = DEFAULT_FREQ_NOMINAL;
+  x.HIST_LO = DEFAULT_HIST_LO;
+  x.HIST_WIDTH = DEFAULT_HIST_WIDTH;
+  x.HIST_GATE = DEFAULT_HIST_GATE;
+  x.SEQUENCE = DEFAULT_SEQUENCE;
   x.NAME[0] = DEFAULT_NAME_0;
   x.NAME[1] = DEFAULT_NAME_1;
   x.PROP_DELAY[0] = DEFAULT_PROP_DELAY_0;
@@ -254,6 +329,14 @@ struct config_t defaultConfig() {
   x.FIXED_TIME2[1] = DEFAULT_FIXED_TIME2_1;
   x.FUDGE0[0] = DEFAULT_FUDGE0_0;
   x.FUDGE0[1] = DEFAULT_FUDGE0_1;
+  for (size_t i = 2; i < NUM_CHANNELS; ++i) {  // extra channels on larger boards
+    x.NAME[i] = (char)(DEFAULT_NAME_0 + i);
+    x.PROP_DELAY[i] = DEFAULT_PROP_DELAY_1;
+    x.START_EDGE[i] = DEFAULT_START_EDGE_1;
+    x.TIME_DILATION[i] = DEFAULT_TIME_DILATION_1;
+    x.FIXED_TIME2[i] = DEFAULT_FIXED_TIME2_1;
+    x.FUDGE0[i] = DEFAULT_FUDGE0_1;
+  }
   return x;
 }
 
@@ -270,7 +353,7 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
   // Skip leading spaces if present, but also handle no-space case
   while (*args == ' ') args++;
   
-  // Direct submenu commands (A1-A6, G1-G6)
+  // Direct submenu commands (A1-A9, G1-G6)
   if (cmd == 'A' && strlen(line) >= 2 && isdigit(line[1])) {
     // Mode submenu commands
     char choice = line[1];
@@ -281,6 +364,9 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
     else if (choice == '4') pConfigInfo->MODE = timeLab;
     else if (choice == '5') pConfigInfo->MODE = Debug;
     else if (choice == '6') pConfigInfo->MODE = Null;
+    else if (choice == '7') pConfigInfo->MODE = Raw;
+    else if (choice == '8') pConfigInfo->MODE = Frequency;
+    else if (choice == '9') pConfigInfo->MODE = Histogram;
     else {
       configPrint("Invalid mode choice\r\n");
       return true;
@@ -295,6 +381,9 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
       case timeLab: modeName = "TimeLab"; break;
       case Debug: modeName = "Debug"; break;
       case Null: modeName = "Null"; break;
+      case Raw: modeName = "Raw Binary"; break;
+      case Frequency: modeName = "Frequency"; break;
+      case Histogram: modeName = "Histogram"; break;
     }
     sprintf(msg, "OK -- Mode set to %s\r\n", modeName); configPrint(msg);
     return true;
@@ -441,6 +530,76 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
         char m[80]; sprintf(m, "OK -- FUDGE0 %ld/%ld -> %ld/%ld\r\n", (long)o0,(long)o1,(long)pConfigInfo->FUDGE0[0],(long)pConfigInfo->FUDGE0[1]); configPrint(m); Serial.flush(); 
       }
     }
+    else if (choice == '7') {
+      // G7) Calibration filter
+      char *cline;
+      if (strlen(args) >= 2) {  // Need at least 2 chars for G7 plus parameter
+        // Direct parameter provided (e.g., "G7I/16/20")
+        cline = args + 1;  // Skip past "G7"
+      } else {
+        // Interactive mode
+        configPrint("Enter filter N/I/M [/refresh [/drift]]: "); 
+        char buf[96];
+        size_t cn = readLine(buf, sizeof(buf)); 
+        cline = trimInPlace(buf);
+      }
+      
+      char f; int64_t r = pConfigInfo->CAL_REFRESH, d = pConfigInfo->CAL_DRIFT;
+      if (!parseCalFilter(cline, &f, &r, &d)) { 
+        configPrint("Invalid\r\n"); Serial.flush(); 
+      } else { 
+        char of=pConfigInfo->CAL_FILTER; int16_t orf=pConfigInfo->CAL_REFRESH, od=pConfigInfo->CAL_DRIFT; 
+        pConfigInfo->CAL_FILTER=f; pConfigInfo->CAL_REFRESH=(int16_t)r; pConfigInfo->CAL_DRIFT=(int16_t)d; 
+        MARK_CONFIG_CHANGED();
+        char m[80]; sprintf(m, "OK -- CalFilter %c/%d/%d -> %c/%d/%d\r\n", of,(int)orf,(int)od,f,(int)r,(int)d); configPrint(m); Serial.flush(); 
+      }
+    }
+    else if (choice == '8') {
+      // G8) Measurement timeout
+      char *cline;
+      if (strlen(args) >= 2) {  // Need at least 2 chars for G8 plus parameter
+        // Direct parameter provided (e.g., "G805/A")
+        cline = args + 1;  // Skip past "G8"
+      } else {
+        // Interactive mode
+        configPrint("Enter timeout hex [/F or /A]: "); 
+        char buf[96];
+        size_t cn = readLine(buf, sizeof(buf)); 
+        cline = trimInPlace(buf);
+      }
+      
+      int16_t t = pConfigInfo->TIMEOUT; char m = pConfigInfo->TIMEOUT_MODE;
+      if (!parseTimeout(cline, &t, &m)) { 
+        configPrint("Invalid\r\n"); Serial.flush(); 
+      } else { 
+        int16_t ot=pConfigInfo->TIMEOUT; char om=pConfigInfo->TIMEOUT_MODE; 
+        pConfigInfo->TIMEOUT=t; pConfigInfo->TIMEOUT_MODE=m; 
+        MARK_CONFIG_CHANGED();
+        char msg[64]; sprintf(msg, "OK -- Timeout 0x%02X/%c -> 0x%02X/%c\r\n", (int)ot,om,(int)t,m); configPrint(msg); Serial.flush(); 
+      }
+    }
+    else if (choice == '9') {
+      // G9) Output format
+      char *cline;
+      if (strlen(args) >= 2) {  // Need at least 2 chars for G9 plus parameter
+        // Direct parameter provided (e.g., "G9B")
+        cline = args + 1;  // Skip past "G9"
+      } else {
+        // Interactive mode
+        configPrint("Enter format A(SCII), B(inary) or D(elta): "); 
+        char buf[96];
+        size_t cn = readLine(buf, sizeof(buf)); 
+        cline = trimInPlace(buf);
+      }
+      
+      char f = toupper(cline[0]);
+      if (f == 'A' || f == 'B' || f == 'D') { 
+        char of=pConfigInfo->FORMAT; pConfigInfo->FORMAT=f; 
+        MARK_CONFIG_CHANGED();
+        char m[64]; sprintf(m, "OK -- Format %c -> %c\r\n", of, f); configPrint(m); 
+      } else configPrint("Invalid\r\n");
+      Serial.flush();
+    }
     else {
       configPrint("Invalid advanced choice\r\n");
     }
@@ -459,6 +618,9 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
       configPrint("A4 - TimeLab 3-Cornered Hat\r\n");
       configPrint("A5 - Debug\r\n");
       configPrint("A6 - Null Output\r\n");
+      configPrint("A7 - Raw Binary\r\n");
+      configPrint("A8 - Frequency (least squares)\r\n");
+      configPrint("A9 - Time Interval Histogram A -> B\r\n");
       configPrint("\r\n");
       configPrint("Current mode: ");
       
@@ -469,6 +631,9 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
         case timeLab:   serialPrintImmediate("TimeLab 3-Cornered Hat"); break;
         case Debug:     serialPrintImmediate("Debug"); break;
         case Null:      serialPrintImmediate("Null Output"); break;
+        case Raw:       serialPrintImmediate("Raw Binary"); break;
+        case Frequency: serialPrintImmediate("Frequency"); break;
+        case Histogram: serialPrintImmediate("Time Interval Histogram A->B"); break;
       }
       serialPrintImmediate("\r\n");
       configPrint("\r\n");
@@ -496,6 +661,9 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
           else if (m == 'A' && mline[1] == '4') pConfigInfo->MODE = timeLab;
           else if (m == 'A' && mline[1] == '5') pConfigInfo->MODE = Debug;
           else if (m == 'A' && mline[1] == '6') pConfigInfo->MODE = Null;
+          else if (m == 'A' && mline[1] == '7') pConfigInfo->MODE = Raw;
+          else if (m == 'A' && mline[1] == '8') pConfigInfo->MODE = Frequency;
+          else if (m == 'A' && mline[1] == '9') pConfigInfo->MODE = Histogram;
           
           // Show mode change confirmation and mark config as changed
           if (old != pConfigInfo->MODE) {
@@ -505,12 +673,18 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
                     (old == Interval) ? "Time Interval A->B" :
                     (old == Period) ? "Period" :
                     (old == timeLab) ? "TimeLab 3-Cornered Hat" :
-                    (old == Debug) ? "Debug" : "Null Output",
+                    (old == Debug) ? "Debug" :
+                    (old == Raw) ? "Raw Binary" :
+                    (old == Frequency) ? "Frequency" :
+                    (old == Histogram) ? "Time Interval Histogram A->B" : "Null Output",
                     (pConfigInfo->MODE == Timestamp) ? "Timestamp" :
                     (pConfigInfo->MODE == Interval) ? "Time Interval A->B" :
                     (pConfigInfo->MODE == Period) ? "Period" :
                     (pConfigInfo->MODE == timeLab) ? "TimeLab 3-Cornered Hat" :
-                    (pConfigInfo->MODE == Debug) ? "Debug" : "Null Output");
+                    (pConfigInfo->MODE == Debug) ? "Debug" :
+                    (pConfigInfo->MODE == Raw) ? "Raw Binary" :
+                    (pConfigInfo->MODE == Frequency) ? "Frequency" :
+                    (pConfigInfo->MODE == Histogram) ? "Time Interval Histogram A->B" : "Null Output");
             serialPrintImmediate(msg);
             MARK_CONFIG_CHANGED();
           }
@@ -669,6 +843,202 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
     return true;
   }
 
+  // J) Baud rate
+  if (cmd == 'J') {
+    char *line;
+    if (strlen(args) >= 1) {
+      // Direct parameter provided (e.g., "J1000000")
+      line = args;
+    } else {
+      // Interactive mode
+      configPrint("Baud rate (e.g. 115200, 500000, 1000000, 2000000): "); 
+      char buf[96];
+      size_t n = readLine(buf, sizeof(buf)); 
+      line = trimInPlace(buf);
+    }
+    
+    int64_t baud; if (parseInt64Simple(line, &baud) && baud >= 300 && baud <= 2000000) { 
+      int32_t old=pConfigInfo->BAUD; pConfigInfo->BAUD = (int32_t)baud; 
+      MARK_CONFIG_CHANGED();
+      char m[64]; sprintf(m, "OK -- Baud %ld -> %ld (after restart)\r\n", (long)old, (long)pConfigInfo->BAUD); configPrint(m); 
+    } else configPrint("Invalid\r\n");
+    Serial.flush();
+    return true;
+  }
+
+  // K) Overload policy
+  if (cmd == 'K') {
+    char *line;
+    if (strlen(args) >= 1) {
+      // Direct parameter provided (e.g., "KO" or "KD/10")
+      line = args;
+    } else {
+      // Interactive mode
+      configPrint("Enter B, N, O or D[/N]: "); 
+      char buf[96];
+      size_t n = readLine(buf, sizeof(buf)); 
+      line = trimInPlace(buf);
+    }
+    
+    char p = toupper(line[0]);
+    int64_t dn = pConfigInfo->OVERLOAD_N;
+    bool ok = (p == 'B' || p == 'N' || p == 'O' || p == 'D');
+    if (ok && line[1] == '/') ok = (p == 'D') && parseInt64Simple(line + 2, &dn) && dn >= 2 && dn <= 1000;
+    else if (ok && line[1]) ok = false;
+    if (ok) { 
+      char op=pConfigInfo->OVERLOAD; int16_t on=pConfigInfo->OVERLOAD_N; 
+      pConfigInfo->OVERLOAD=p; pConfigInfo->OVERLOAD_N=(int16_t)dn; 
+      MARK_CONFIG_CHANGED();
+      char m[64]; sprintf(m, "OK -- Overload %c/%d -> %c/%d\r\n", op, (int)on, p, (int)dn); configPrint(m); 
+    } else configPrint("Invalid\r\n");
+    Serial.flush();
+    return true;
+  }
+
+  // L) Aggregation
+  if (cmd == 'L') {
+    char *line;
+    if (strlen(args) >= 1) {
+      // Direct parameter provided (e.g., "LN/1000" or "LO")
+      line = args;
+    } else {
+      // Interactive mode
+      configPrint("Enter O, N/<events> or T/<ticks>: "); 
+      char buf[96];
+      size_t n = readLine(buf, sizeof(buf)); 
+      line = trimInPlace(buf);
+    }
+    
+    char a = toupper(line[0]);
+    int64_t g = pConfigInfo->AGG_GATE;
+    bool ok = (a == 'O' || a == 'N' || a == 'T');
+    if (ok && line[1] == '/') ok = (a != 'O') && parseInt64Simple(line + 2, &g) && g >= 1 && g <= 100000000;
+    else if (ok && line[1]) ok = false;
+    if (ok) { 
+      char oa=pConfigInfo->AGGREGATE; long og=(long)pConfigInfo->AGG_GATE; 
+      pConfigInfo->AGGREGATE=a; pConfigInfo->AGG_GATE=(int32_t)g; 
+      MARK_CONFIG_CHANGED();
+      char m[64]; sprintf(m, "OK -- Aggregate %c/%ld -> %c/%ld\r\n", oa, og, a, (long)g); configPrint(m); 
+    } else configPrint("Invalid\r\n");
+    Serial.flush();
+    return true;
+  }
+
+  // N) Stability table
+  if (cmd == 'N') {
+    char *line;
+    if (strlen(args) >= 1) {
+      // Direct parameter provided (e.g., "NP/60" or "NR")
+      line = args;
+    } else {
+      // Interactive mode
+      configPrint("Enter O, R or P[/seconds]: "); 
+      char buf[96];
+      size_t n = readLine(buf, sizeof(buf)); 
+      line = trimInPlace(buf);
+    }
+    
+    char a = toupper(line[0]);
+    int64_t sec = pConfigInfo->ADEV_PERIOD;
+    bool ok = (a == 'O' || a == 'R' || a == 'P');
+    if (ok && line[1] == '/') ok = (a == 'P') && parseInt64Simple(line + 2, &sec) && sec >= 1 && sec <= 32767;
+    else if (ok && line[1]) ok = false;
+    if (ok) { 
+      char oa=pConfigInfo->ADEV; int16_t os=pConfigInfo->ADEV_PERIOD; 
+      pConfigInfo->ADEV=a; pConfigInfo->ADEV_PERIOD=(int16_t)sec; 
+      MARK_CONFIG_CHANGED();
+      char m[64]; sprintf(m, "OK -- Stability %c/%d -> %c/%d\r\n", oa, (int)os, a, (int)sec); configPrint(m); 
+    } else configPrint("Invalid\r\n");
+    Serial.flush();
+    return true;
+  }
+
+  // O) Frequency mode gate and nominal
+  if (cmd == 'O') {
+    char *line;
+    if (strlen(args) >= 1) {
+      // Direct parameter provided (e.g., "O10000/10000000")
+      line = args;
+    } else {
+      // Interactive mode
+      configPrint("Enter gate ticks[/nominal Hz]: "); 
+      char buf[96];
+      size_t n = readLine(buf, sizeof(buf)); 
+      line = trimInPlace(buf);
+    }
+    
+    int64_t g = 0, f = 0;
+    char *slash = strchr(line, '/');
+    if (slash) *slash = 0;
+    bool ok = parseInt64Simple(line, &g) && g >= 1 && g <= 100000000;
+    if (ok && slash) ok = parseInt64Simple(slash + 1, &f) && f >= 0 && f <= 2000000000;
+    if (ok) { 
+      long og=(long)pConfigInfo->FREQ_GATE, of=(long)pConfigInfo->FREQ_NOMINAL; 
+      pConfigInfo->FREQ_GATE=(int32_t)g; pConfigInfo->FREQ_NOMINAL=(int32_t)f; 
+      MARK_CONFIG_CHANGED();
+      char m[64]; sprintf(m, "OK -- Frequency %ld/%ld -> %ld/%ld\r\n", og, of, (long)g, (long)f); configPrint(m); 
+    } else configPrint("Invalid\r\n");
+    Serial.flush();
+    return true;
+  }
+
+  // P) Histogram bins and gate
+  if (cmd == 'P') {
+    char *line;
+    if (strlen(args) >= 1) {
+      // Direct parameter provided (e.g., "P-5000/100/10000")
+      line = args;
+    } else {
+      // Interactive mode
+      configPrint("Enter lo ps/width ps[/gate pairs]: "); 
+      char buf[96];
+      size_t n = readLine(buf, sizeof(buf)); 
+      line = trimInPlace(buf);
+    }
+    
+    int64_t lo = 0, w = 0, g = pConfigInfo->HIST_GATE;
+    char *s1 = strchr(line, '/');
+    char *s2 = s1 ? strchr(s1 + 1, '/') : 0;
+    if (s1) *s1 = 0;
+    if (s2) *s2 = 0;
+    bool ok = s1 && parseInt64Simple(line, &lo) && parseInt64Simple(s1 + 1, &w) &&
+              w >= 1 && w <= 2000000000;
+    if (ok && s2) ok = parseInt64Simple(s2 + 1, &g) && g >= 0 && g <= 2000000000;
+    if (ok) { 
+      pConfigInfo->HIST_LO=lo; pConfigInfo->HIST_WIDTH=(int32_t)w; pConfigInfo->HIST_GATE=(int32_t)g; 
+      MARK_CONFIG_CHANGED();
+      char b[24]; format_int64_to_buffer(b, sizeof(b), lo);
+      char m[80]; sprintf(m, "OK -- Histogram %s/%ld/%ld\r\n", b, (long)w, (long)g); configPrint(m); 
+    } else configPrint("Invalid\r\n");
+    Serial.flush();
+    return true;
+  }
+
+  // Q) Sequence numbers and overrun records
+  if (cmd == 'Q') {
+    char *line;
+    if (strlen(args) >= 1) {
+      // Direct parameter provided (e.g., "QY")
+      line = args;
+    } else {
+      // Interactive mode
+      configPrint("Enter Y or N: "); 
+      char buf[96];
+      size_t n = readLine(buf, sizeof(buf)); 
+      line = trimInPlace(buf);
+    }
+    
+    char q = toupper(line[0]);
+    if ((q == 'Y' || q == 'N') && !line[1]) { 
+      char oq=pConfigInfo->SEQUENCE; 
+      pConfigInfo->SEQUENCE=q; 
+      MARK_CONFIG_CHANGED();
+      char m[48]; sprintf(m, "OK -- Sequence %c -> %c\r\n", oq, q); configPrint(m); 
+    } else configPrint("Invalid\r\n");
+    Serial.flush();
+    return true;
+  }
+
   // I) Show startup info
   if (cmd == 'I') {
     configPrint("\r\n");
@@ -739,6 +1109,27 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
         configPrint(tmp);
       }
       
+      // H7 - Calibration filter/refresh/drift
+      {
+        char tmp[72]; 
+        sprintf(tmp, "H7 - Cal Filter/Refresh/Drift (currently: %c/%d/%d)\r\n", pConfigInfo->CAL_FILTER, (int)pConfigInfo->CAL_REFRESH, (int)pConfigInfo->CAL_DRIFT);
+        configPrint(tmp);
+      }
+      
+      // H8 - Measurement timeout
+      {
+        char tmp[72]; 
+        sprintf(tmp, "H8 - Timeout hex/Mode F/A (currently: 0x%02X/%c)\r\n", (int)pConfigInfo->TIMEOUT, pConfigInfo->TIMEOUT_MODE);
+        configPrint(tmp);
+      }
+      
+      // H9 - Output format
+      {
+        char tmp[64]; 
+        sprintf(tmp, "H9 - Output Format A/B/D (currently: %c)\r\n", pConfigInfo->FORMAT);
+        configPrint(tmp);
+      }
+      
       configPrint("1 - Discard changes and return to main menu\r\n");
       configPrint("2 - Keep changes and return to main menu\r\n");
       configPrint("> ");
@@ -791,6 +1182,22 @@ static bool processCommand(struct config_t *pConfigInfo, char *cmdLine, bool *sh
             configPrint("Enter pair A/B: "); size_t cn = readLine(buf, sizeof(buf)); char *cline = trimInPlace(buf);
             bool s0=false, s1=false; int64_t v0=0, v1=0; if (!parseInt64Pair(cline, &s0, &v0, &s1, &v1)) { configPrint("Invalid\r\n"); Serial.flush(); } else { int32_t o0=pConfigInfo->FUDGE0[0], o1=pConfigInfo->FUDGE0[1]; if (s0) pConfigInfo->FUDGE0[0]=v0; if (s1) pConfigInfo->FUDGE0[1]=v1; char m[80]; sprintf(m, "OK -- FUDGE0 %ld/%ld -> %ld/%ld\r\n", (long)o0,(long)o1,(long)pConfigInfo->FUDGE0[0],(long)pConfigInfo->FUDGE0[1]); configPrint(m); Serial.flush(); }
           }
+          // H7) Calibration filter
+          else if (a == 'H' && aline[1] == '7') {
+            configPrint("Enter filter N/I/M [/refresh [/drift]]: "); size_t cn = readLine(buf, sizeof(buf)); char *cline = trimInPlace(buf);
+            char f; int64_t r = pConfigInfo->CAL_REFRESH, d = pConfigInfo->CAL_DRIFT; if (!parseCalFilter(cline, &f, &r, &d)) { configPrint("Invalid\r\n"); Serial.flush(); } else { char of=pConfigInfo->CAL_FILTER; int16_t orf=pConfigInfo->CAL_REFRESH, od=pConfigInfo->CAL_DRIFT; pConfigInfo->CAL_FILTER=f; pConfigInfo->CAL_REFRESH=(int16_t)r; pConfigInfo->CAL_DRIFT=(int16_t)d; MARK_CONFIG_CHANGED(); char m[80]; sprintf(m, "OK -- CalFilter %c/%d/%d -> %c/%d/%d\r\n", of,(int)orf,(int)od,f,(int)r,(int)d); configPrint(m); Serial.flush(); }
+          }
+          // H8) Measurement timeout
+          else if (a == 'H' && aline[1] == '8') {
+            configPrint("Enter timeout hex [/F or /A]: "); size_t cn = readLine(buf, sizeof(buf)); char *cline = trimInPlace(buf);
+            int16_t t = pConfigInfo->TIMEOUT; char m = pConfigInfo->TIMEOUT_MODE; if (!parseTimeout(cline, &t, &m)) { configPrint("Invalid\r\n"); Serial.flush(); } else { int16_t ot=pConfigInfo->TIMEOUT; char om=pConfigInfo->TIMEOUT_MODE; pConfigInfo->TIMEOUT=t; pConfigInfo->TIMEOUT_MODE=m; MARK_CONFIG_CHANGED(); char msg[64]; sprintf(msg, "OK -- Timeout 0x%02X/%c -> 0x%02X/%c\r\n", (int)ot,om,(int)t,m); configPrint(msg); Serial.flush(); }
+          }
+          // H9) Output format
+          else if (a == 'H' && aline[1] == '9') {
+            configPrint("Enter format A(SCII), B(inary) or D(elta): "); size_t cn = readLine(buf, sizeof(buf)); char *cline = trimInPlace(buf);
+            char f = toupper(cline[0]); if (f == 'A' || f == 'B' || f == 'D') { char of=pConfigInfo->FORMAT; pConfigInfo->FORMAT=f; MARK_CONFIG_CHANGED(); char m[64]; sprintf(m, "OK -- Format %c -> %c\r\n", of, f); configPrint(m); } else configPrint("Invalid\r\n");
+            Serial.flush();
+          }
           else { configPrint("Invalid\r\n"); Serial.flush(); }
         }
       }
@@ -842,6 +1249,9 @@ void doSetupMenu(struct config_t *pConfigInfo)      // line-oriented, robust ser
         case timeLab:   serialPrintImmediate("TimeLab 3-ch"); break;
         case Debug:     serialPrintImmediate("Debug"); break;
         case Null:      serialPrintImmediate("Null"); break;
+        case Raw:       serialPrintImmediate("Raw"); break;
+        case Frequency: serialPrintImmediate("Frequency"); break;
+        case Histogram: serialPrintImmediate("Histogram A->B"); break;
       }
       serialPrintImmediate(")\r\n");
       // B) Wrap digits
@@ -879,6 +1289,42 @@ void doSetupMenu(struct config_t *pConfigInfo)      // line-oriented, robust ser
       serialPrintImmediate(")\r\n");
       // H) Advanced settings
       configPrint("H - Advanced settings\r\n");
+      // J) Baud rate
+      {
+        char tmp[48]; sprintf(tmp, "J - Baud Rate (currently: %ld)\r\n", (long)pConfigInfo->BAUD);
+        configPrint(tmp);
+      }
+      // K) Overload policy
+      {
+        char tmp[64]; sprintf(tmp, "K - Overload Policy B/N/O/D[/N] (currently: %c/%d)\r\n", pConfigInfo->OVERLOAD, (int)pConfigInfo->OVERLOAD_N);
+        configPrint(tmp);
+      }
+      // L) Aggregation
+      {
+        char tmp[64]; sprintf(tmp, "L - Aggregate O/N/T[/gate] (currently: %c/%ld)\r\n", pConfigInfo->AGGREGATE, (long)pConfigInfo->AGG_GATE);
+        configPrint(tmp);
+      }
+      // N) Stability table
+      {
+        char tmp[64]; sprintf(tmp, "N - ADEV/MDEV Table O/R/P[/s] (currently: %c/%d)\r\n", pConfigInfo->ADEV, (int)pConfigInfo->ADEV_PERIOD);
+        configPrint(tmp);
+      }
+      // O) Frequency gate
+      {
+        char tmp[64]; sprintf(tmp, "O - Frequency Gate ticks[/Hz] (currently: %ld/%ld)\r\n", (long)pConfigInfo->FREQ_GATE, (long)pConfigInfo->FREQ_NOMINAL);
+        configPrint(tmp);
+      }
+      // P) Histogram bins
+      {
+        char lo[24]; format_int64_to_buffer(lo, sizeof(lo), pConfigInfo->HIST_LO);
+        char tmp[80]; sprintf(tmp, "P - Histogram lo/width/gate (currently: %s/%ld/%ld)\r\n", lo, (long)pConfigInfo->HIST_WIDTH, (long)pConfigInfo->HIST_GATE);
+        configPrint(tmp);
+      }
+      // Q) Sequence numbers
+      {
+        char tmp[64]; sprintf(tmp, "Q - Sequence Numbers Y/N (currently: %c)\r\n", pConfigInfo->SEQUENCE);
+        configPrint(tmp);
+      }
       configPrint("\r\n");
       configPrint("M - Show this menu again\r\n");
       configPrint("I - Show startup info\r\n");
@@ -982,6 +1428,15 @@ void print_MeasureMode(MeasureMode x) {
     case Debug:
       Serial.println("Debug");
       break;
+    case Raw:
+      Serial.println("Raw Binary");
+      break;
+    case Frequency:
+      Serial.println("Frequency");
+      break;
+    case Histogram:
+      Serial.println("Time Interval Histogram A->B");
+      break;
   }  
 }
 
@@ -1026,6 +1481,58 @@ void print_config (config_t x) {
   // Channel Names
   Serial.print("# Channel Names: ");Serial.print(x.NAME[0]);Serial.print("/");Serial.println(x.NAME[1]);
   
+  // Baud rate
+  Serial.print("# Baud Rate: ");Serial.print(x.BAUD);
+  Serial.print(" (banner and config prompt at ");Serial.print(BOOT_BAUD);Serial.println(")");
+  
+  // Overload policy
+  Serial.print("# Overload Policy: ");
+  switch (x.OVERLOAD) {
+    case 'N': Serial.println("drop newest"); break;
+    case 'O': Serial.println("drop oldest"); break;
+    case 'D': Serial.print("decimate 1/");Serial.println(x.OVERLOAD_N); break;
+    default:  Serial.println("block"); break;
+  }
+  
+  // Aggregation
+  Serial.print("# Aggregate: ");
+  switch (x.AGGREGATE) {
+    case 'N': Serial.print("per ");Serial.print(x.AGG_GATE);Serial.println(" events"); break;
+    case 'T': Serial.print("per ");Serial.print(x.AGG_GATE);Serial.println(" ticks"); break;
+    default:  Serial.println("off"); break;
+  }
+  
+  // Stability table
+  Serial.print("# ADEV/MDEV Table: ");
+  switch (x.ADEV) {
+    case 'R': Serial.println("on request ('?')"); break;
+    case 'P': Serial.print("every ");Serial.print(x.ADEV_PERIOD);Serial.println(" s and on request ('?')"); break;
+    default:  Serial.println("off"); break;
+  }
+  
+  // Frequency mode
+  Serial.print("# Frequency Gate: ");
+  Serial.print(x.FREQ_GATE);
+  if (x.FREQ_NOMINAL) {
+    Serial.print(" ticks, offset from ");Serial.print(x.FREQ_NOMINAL);Serial.println(" Hz");
+  } else {
+    Serial.println(" ticks, in Hz");
+  }
+  
+  // Histogram mode
+  Serial.print("# Histogram: ");
+  Serial.print(HIST_BINS);Serial.print(" bins of ");Serial.print(x.HIST_WIDTH);
+  Serial.print(" ps from ");print_int64(x.HIST_LO);Serial.print(" ps, ");
+  if (x.HIST_GATE) {
+    Serial.print("per ");Serial.print(x.HIST_GATE);Serial.println(" pairs");
+  } else {
+    Serial.println("on request ('?')");
+  }
+  
+  // Sequence numbers
+  Serial.print("# Sequence Numbers: ");
+  Serial.println((x.SEQUENCE == 'Y') ? "on, with overrun records" : "off");
+  
   // Poll Character (moved to follow Channel Names)
   Serial.print("# Poll Character: ");
   if (x.POLL_CHAR) {
@@ -1043,13 +1550,24 @@ void print_config (config_t x) {
   // Cal Periods
   Serial.print("# Cal Periods: ");Serial.println(x.CAL_PERIODS);
   
+  // Calibration filter
+  Serial.print("# Cal Filter: ");Serial.print(x.CAL_FILTER);
+  Serial.print(", refresh ");Serial.print(x.CAL_REFRESH);
+  Serial.print(", drift ");Serial.println(x.CAL_DRIFT);
+  
+  // Output format
+  Serial.print("# Output Format: ");
+  Serial.println((x.FORMAT == 'B') ? "Binary (COBS frames)" :
+                 (x.FORMAT == 'D') ? "Delta (COBS frames)" : "ASCII");
+  
   // PropDelay
   Serial.print("# PropDelay: ");Serial.print((int32_t)x.PROP_DELAY[0]);
   Serial.print(" (ch0), ");Serial.print((int32_t)x.PROP_DELAY[1]);Serial.println(" (ch1)");
   
   // Timeout
   Serial.print("# Timeout: ");
-  sprintf(tmpbuf,"0x%.2X",x.TIMEOUT);Serial.println(tmpbuf);
+  sprintf(tmpbuf,"0x%.2X",x.TIMEOUT);Serial.print(tmpbuf);
+  Serial.println((x.TIMEOUT_MODE == 'A') ? " (adaptive)" : " (fixed)");
   
   // Time Dilation
   Serial.print("# Time Dilation: ");Serial.print((int32_t)x.TIME_DILATION[0]);
@@ -12,12 +12,15 @@
 
 #define PS_PER_SEC                (int64_t)  1000000000000   // ps/s
 
-enum MeasureMode : unsigned char {Timestamp, Interval, Period, timeLab, Debug, Null};
+enum MeasureMode : unsigned char {Timestamp, Interval, Period, timeLab, Debug, Null, Raw, Frequency, Histogram};
 
 /*****************************************************************/
 // system defines
 #define BOARD_REVISION            'D'                   // production version is 'D'
-#define EEPROM_VERSION            (byte)     11         // eeprom struct version
+#ifndef NUM_CHANNELS
+#define NUM_CHANNELS              2                     // TDC7200s fitted; pin map in board.h
+#endif
+#define EEPROM_VERSION            (byte)     21         // eeprom struct version
 #define CONFIG_START              (byte)     0x00       // first byte of config in eeprom
 #define SER_NUM_START             (int16_t)  0x0FF0     // first byte of serial number in eeprom
 /*****************************************************************/
@@ -28,9 +31,27 @@ enum MeasureMode : unsigned char {Timestamp, Interval, Period, timeLab, Debug, N
 #define DEFAULT_PICTICK_PS        (int64_t) 100000000   // 100us
 #define DEFAULT_CAL_PERIODS       (int16_t) 20          // CAL_PERIODS (2, 10, 20, 40)
 #define DEFAULT_TIMEOUT           (int16_t) 0x05        // measurement timeout
+#define DEFAULT_TIMEOUT_MODE      (char)    'F'         // (F)ixed or (A)daptive timeout
 #define DEFAULT_WRAP              (int16_t) 0           // timestamp rollover in 100 us ticks; max 2^63 - 1
 #define DEFAULT_PLACES            (int16_t) 11          // decimal places for output (0-12, default 11)
 #define DEFAULT_SYNC_MODE         (char)    'M'         // (M)aster or (C)lient
+#define DEFAULT_CAL_FILTER        (char)    'N'         // calibration filter: (N)one, (I)IR, (M)edian
+#define DEFAULT_CAL_REFRESH       (int16_t) 1           // re-read calibration every N events
+#define DEFAULT_CAL_DRIFT         (int16_t) 0           // re-seed filter on drift > N counts (0 = off)
+#define DEFAULT_FORMAT            (char)    'A'         // output format: (A)SCII, (B)inary or (D)elta frames
+#define DEFAULT_BAUD              (int32_t) 115200      // serial rate for data (up to 2000000)
+#define DEFAULT_OVERLOAD          (char)    'B'         // link overload: (B)lock, drop (N)ewest, drop (O)ldest, (D)ecimate
+#define DEFAULT_OVERLOAD_N        (int16_t) 10          // 'D' passes every Nth record per channel
+#define DEFAULT_AGGREGATE         (char)    'O'         // Period/Interval statistics: (O)ff, per (N) events, per (T)icks
+#define DEFAULT_AGG_GATE          (int32_t) 1000        // gate length in events or coarse ticks
+#define DEFAULT_ADEV              (char)    'O'         // ADEV/MDEV table: (O)ff, on (R)equest, (P)eriodic
+#define DEFAULT_ADEV_PERIOD       (int16_t) 60          // seconds between periodic tables
+#define DEFAULT_FREQ_GATE         (int32_t) 10000       // Frequency mode gate in coarse ticks (1 s)
+#define DEFAULT_FREQ_NOMINAL      (int32_t) 0           // 0 to report Hz, else offset from this many Hz
+#define DEFAULT_HIST_LO           (int64_t) 0           // Histogram mode: first bin starts here (ps)
+#define DEFAULT_HIST_WIDTH        (int32_t) 1000        // bin width (ps)
+#define DEFAULT_HIST_GATE         (int32_t) 10000       // pairs per histogram (0 = on request only)
+#define DEFAULT_SEQUENCE          (char)    'N'         // (Y) tag data lines with event counts and report overruns
 #define DEFAULT_NAME_0            (char)    'A'
 #define DEFAULT_NAME_1            (char)    'B'
 #define DEFAULT_PROP_DELAY_0      (int64_t)  0
@@ -54,23 +75,42 @@ struct config_t {
   
   // global settings:
   MeasureMode MODE;                     // (T)imestamp, time (I)nterval
-                                        // Time(L)ab, (P)eriod, (D)ebug (default 'T')
+                                        // Time(L)ab, (P)eriod, (D)ebug,
+                                        // (F)requency, (H)istogram (default 'T')
   char       POLL_CHAR;                 // In poll mode, wiat for this before output
   int64_t    CLOCK_HZ;                  // clock in Hz (default 10 000 000)
   int64_t    PICTICK_PS;                // coarse tick (default 100 000 000)
   int16_t    CAL_PERIODS;               // cal periods 2, 10, 20, 40 (default 20)
   int16_t    TIMEOUT;                   // timeout for measurement in hex (default 0x05)
+  char       TIMEOUT_MODE;              // (F)ixed, or (A)daptive with TIMEOUT as ceiling (default 'F')
   int16_t    WRAP;                      // wraparound value for PICcount
   int16_t    PLACES;                    // decimal places for output (0-12, default 11)
   char       SYNC_MODE;                 // one byte:  'M' for master,  'C' for client
+  char       CAL_FILTER;                // calibration filter: (N)one, (I)IR, (M)edian (default 'N')
+  int16_t    CAL_REFRESH;               // read CALIBRATION1/2 every N events (default 1)
+  int16_t    CAL_DRIFT;                 // raw vs. filtered cal counts that force re-seed (default 0 = off)
+  char       FORMAT;                    // (A)SCII lines, (B)inary or (D)elta COBS frames (default 'A')
+  int32_t    BAUD;                      // serial rate after the config prompt (default 115200)
+  char       OVERLOAD;                  // (B)lock, drop (N)ewest, drop (O)ldest, (D)ecimate (default 'B')
+  int16_t    OVERLOAD_N;                // decimation factor for 'D' (default 10)
+  char       AGGREGATE;                 // (O)ff, gate of (N) events or (T)icks (default 'O')
+  int32_t    AGG_GATE;                  // gate length (default 1000)
+  char       ADEV;                      // ADEV/MDEV table (O)ff, on (R)equest, (P)eriodic (default 'O')
+  int16_t    ADEV_PERIOD;               // seconds between periodic tables (default 60)
+  int32_t    FREQ_GATE;                 // Frequency mode gate in coarse ticks (default 10000)
+  int32_t    FREQ_NOMINAL;              // 0 reports Hz, else fractional offset from it (default 0)
+  int64_t    HIST_LO;                   // Histogram mode: start of the first bin, ps (default 0)
+  int32_t    HIST_WIDTH;                // bin width, ps (default 1000)
+  int32_t    HIST_GATE;                 // pairs per histogram, 0 = on request only (default 10000)
+  char       SEQUENCE;                  // (Y) sequence numbers and overrun records, (N) off (default 'N')
   
-  // per-channel settings, arrays of 2 for channels 0 and 1:
-  char       START_EDGE[2];            // (R)ising (default) or (F)alling edge 
-  char       NAME[2];                  // user-set channel name
-  int64_t    PROP_DELAY[2];            // user-set offset value (ps)
-  int64_t    TIME_DILATION[2];         // time dilation factor (default 2500)
-  int64_t    FIXED_TIME2[2];           // if >0 use to replace time2 (default 0)
-  int64_t    FUDGE0[2];                // fudge factor (ps) (default 0)
+  // per-channel settings, one entry per channel:
+  char       START_EDGE[NUM_CHANNELS];    // (R)ising (default) or (F)alling edge 
+  char       NAME[NUM_CHANNELS];          // user-set channel name
+  int64_t    PROP_DELAY[NUM_CHANNELS];    // user-set offset value (ps)
+  int64_t    TIME_DILATION[NUM_CHANNELS]; // time dilation factor (default 2500)
+  int64_t    FIXED_TIME2[NUM_CHANNELS];   // if >0 use to replace time2 (default 0)
+  int64_t    FUDGE0[NUM_CHANNELS];        // fudge factor (ps) (default 0)
   
 };
 
@@ -0,0 +1,160 @@
+// freq.cpp -- least-squares (Omega) frequency counter
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"           // config and eeprom
+#include "misc.h"             // SplitTime and U128 helpers
+#include "freq.h"
+#include "record.h"           // REC_*_LEN field widths
+
+extern config_t config;
+
+struct FreqSlot {
+  SplitTime t0;               // gate's first timestamp; y is ps from it
+  int64_t   seq0;             // gate's first event number; i is counted from it
+  int64_t   gate_start;       // coarse tick the gate opened at
+  uint64_t  si;               // sum of i
+  uint64_t  sii;              // sum of i * i
+  U128      sy;               // sum of y
+  U128      siy;              // sum of i * y
+  uint32_t  n;
+};
+static FreqSlot slots[NUM_CHANNELS];
+
+void freq_reset() {
+  memset(slots, 0, sizeof(slots));
+}
+
+static void finish(FreqSlot &s, FreqResult *out) {
+  uint32_t n = s.n;
+  // sum(i) < 2^40, so sum(i) sum(y) is taken in two 32-bit halves
+  U128 b = u128_mul32(s.sy, (uint32_t)s.si);
+  u128_add(&b, u128_shl(u128_mul32(s.sy, (uint32_t)(s.si >> 32)), 32));
+  out->num = u128_mul32(s.siy, n);
+  u128_sub(&out->num, b);
+  out->den = u128_mul64(n, s.sii);
+  u128_sub(&out->den, u128_mul64(s.si, s.si));
+  out->n = n;
+  s.n = 0;
+}
+
+bool freq_add(uint8_t ch, const SplitTime &t, int64_t tick, int64_t seq,
+              FreqResult *done) {
+  FreqSlot &s = slots[ch];
+  bool closed = false;
+
+  bool over = (tick - s.gate_start) >= config.FREQ_GATE;
+  if (s.n && (over || ((seq - s.seq0) >= (int64_t)FREQ_MAX_EVENTS))) {
+    if (s.n >= 2) {
+      finish(s, done);
+      closed = true;
+    }
+    s.n = 0;
+    if (over) s.gate_start += ((tick - s.gate_start) / config.FREQ_GATE) * config.FREQ_GATE;
+    else s.gate_start = tick;
+  } else if (!s.n) {
+    s.gate_start = tick;
+  }
+
+  if (!s.n) {
+    s.t0 = t;
+    s.seq0 = seq;
+    s.si = 0;
+    s.sii = 0;
+    memset(&s.sy, 0, sizeof(s.sy));
+    memset(&s.siy, 0, sizeof(s.siy));
+  } else {
+    uint64_t i = (uint64_t)(seq - s.seq0);
+    uint64_t y = (uint64_t)splitToPs(diffSplit(t, s.t0));
+    U128 w = {0, y};
+    s.si += i;
+    s.sii += i * i;
+    u128_add(&s.sy, w);
+    u128_add(&s.siy, u128_mul64(i, y));
+  }
+  s.n++;
+  return closed;
+}
+
+static uint8_t bits(const U128 &a) {
+  uint8_t b = 0;
+  for (U128 x = a; x.hi || x.lo; x = u128_shr(x, 1)) b++;
+  return b;
+}
+
+// Shift a and b right together until b has at most keep bits
+static void scale(U128 *a, U128 *b, uint8_t keep) {
+  for (uint8_t s = bits(*b); s > keep; ) {
+    uint8_t k = (s - keep > 32) ? 32 : s - keep;
+    *a = u128_shr(*a, k);
+    *b = u128_shr(*b, k);
+    s -= k;
+  }
+}
+
+// Next decimal digit of rem / d, with rem < d < 2^124
+static char next_digit(U128 *rem, const U128 &d) {
+  U128 r = u128_mul32(*rem, 10);
+  char c = '0';
+  while (!u128_lt(r, d)) {
+    u128_sub(&r, d);
+    c++;
+  }
+  *rem = r;
+  return c;
+}
+
+// Frequency line: 12 integer digits, '.' and up to 12 places, " <n>"
+static_assert(12 + 1 + 12 + 1 + REC_U32_LEN + REC_CH_TAG_LEN + REC_EOL_LEN <= LINE_DATA_MAX,
+              "frequency line does not fit LINE_DATA_MAX");
+
+size_t formatFrequency(char *buf, size_t cap, const FreqResult &r, int places, int32_t nominal) {
+  char *p = buf; const char *end = buf + cap;
+
+  if (!nominal) {
+    // f = 10^12 den / num Hz.  den < num (events are at least a ps
+    // apart), so the digits of den / num from 10^-1 on are those of f
+    // from 10^11 on; long division keeps it exact with no 10^12 factor.
+    U128 rem = r.den;
+    for (uint8_t k = 0; k < 12; ++k) {
+      char c = next_digit(&rem, r.num);
+      if (((p > buf) || (c != '0') || (k == 11)) && (p < end)) *p++ = c;
+    }
+    if ((places > 0) && (p < end)) {
+      *p++ = '.';
+      for (int k = 0; (k < places) && (p < end); ++k) *p++ = next_digit(&rem, r.num);
+    }
+  } else {
+    // (f - f0) / f0 = (10^12 den - f0 num) / (f0 num), scaled down
+    // together until f0 num fits, then until both fit in 64 bits
+    U128 a = u128_mul32(u128_mul32(r.den, 1000000UL), 1000000UL);
+    U128 b = r.num;
+    scale(&a, &b, 95);
+    b = u128_mul32(b, (uint32_t)nominal);
+    bool neg = u128_lt(a, b);
+    if (neg) {
+      U128 t = b;
+      u128_sub(&t, a);
+      a = t;
+    } else {
+      u128_sub(&a, b);
+    }
+    if (u128_lt(a, b)) scale(&a, &b, 63);
+    else scale(&b, &a, 63);
+    char t[9];                // "d.ddde+xx"
+    size_t k = formatSci(t, a.lo, b.lo ? b.lo : 1);
+    if (neg && (p < end)) *p++ = '-';
+    for (size_t j = 0; (j < k) && (p < end); ++j) *p++ = t[j];
+  }
+  if (p < end) {
+    *p++ = ' ';
+    p += formatU32(p, (size_t)(end - p), r.n, 1);
+  }
+  return (size_t)(p - buf);
+}
@@ -0,0 +1,56 @@
+#ifndef FREQ_H
+#define FREQ_H
+
+// freq.h -- least-squares (Omega) frequency counter
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+// In Frequency mode each channel's timestamps t_i over a gate of
+// config.FREQ_GATE coarse ticks are fitted with the line t_i = t_0 + i T,
+// where i is the event's number (seq()) less that of the gate's first
+// event.  Events lost to a timeout leave a gap in i instead of pulling
+// the slope, and one line goes out per gate:
+//   <frequency in Hz> <n> chX            (FREQ_NOMINAL 0)
+//   <(f - f0) / f0> <n> chX              (FREQ_NOMINAL f0 in Hz)
+// Against the usual first-to-last count, the fit averages the jitter of
+// every timestamp, so white phase noise falls as gate^-3/2, not gate^-1.
+//
+// No timestamps are kept.  With y_i = t_i - t_0 in ps the slope is
+//   T = (n sum(i y) - sum(i) sum(y)) / (n sum(i i) - sum(i)^2)
+// and sum(y) and sum(i y) are held exactly in 128 bits, so a gate costs
+// a few additions and multiplies per event and the result is exact up
+// to its formatting.  As with Aggregate, a gate ends with the first
+// event past it, which also opens the next one; a gate needs at least
+// two events, and ends early once i reaches FREQ_MAX_EVENTS, which keeps
+// the sums within their widths.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef FREQ_MAX_EVENTS
+#define FREQ_MAX_EVENTS  (1UL << 20)  // a gate ends early at this many event numbers
+#endif
+
+// SplitTime and U128 come from misc.h, which must be included first
+
+struct FreqResult {
+  U128     num;               // n sum(i y) - sum(i) sum(y), ps
+  U128     den;               // n sum(i i) - sum(i)^2; T = num / den ps
+  uint32_t n;
+};
+
+void freq_reset();
+// Add channel ch's timestamp t of event number seq, taken at coarse tick
+// tick.  Returns true when that closed a gate, whose fit is then in *done.
+bool freq_add(uint8_t ch, const SplitTime &t, int64_t tick, int64_t seq,
+              FreqResult *done);
+// Frequency with places decimals, or the offset from nominal Hz when
+// nominal is not 0, then " <n>"; writes at most cap bytes and returns
+// how many it wrote
+size_t formatFrequency(char *buf, size_t cap, const FreqResult &r, int places,
+                       int32_t nominal);
+
+#endif  /* FREQ_H */
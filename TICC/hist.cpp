@@ -0,0 +1,73 @@
+// hist.cpp -- on-board time interval histogram
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"           // config and eeprom
+#include "misc.h"             // SplitTime helpers
+#include "hist.h"
+#include "uart0.h"            // USART0 driver; remaps Serial
+#include "output.h"           // record output and overload policy
+#include "record.h"           // output line builder
+
+extern config_t config;
+
+// "<bin> <8 counts> H(A->B)" and CRLF
+#define LINE_HIST_MAX  (3 + 8 * (1 + REC_U32_LEN) + 8 + REC_EOL_LEN)
+
+static uint32_t bins[HIST_BINS];
+static uint32_t under, over, pairs;
+
+void hist_reset() {
+  memset(bins, 0, sizeof(bins));
+  under = 0;
+  over = 0;
+  pairs = 0;
+}
+
+void hist_add(const SplitTime &d) {
+  int64_t off = splitToPs(d) - config.HIST_LO;
+  uint32_t w = (uint32_t)config.HIST_WIDTH;
+
+  if (off < 0) under++;
+  else if (off >= (int64_t)w * HIST_BINS) over++;
+  else if (off <= (int64_t)UINT32_MAX) bins[(uint32_t)off / w]++;
+  else bins[off / w]++;
+  pairs++;
+
+  if (config.HIST_GATE && (pairs >= (uint32_t)config.HIST_GATE)) {
+    hist_report();
+    hist_reset();
+  }
+}
+
+void hist_report() {
+  static const char tag[] = " H(A->B)";
+
+  for (uint8_t k = 0; k < HIST_BINS; k += 8) {
+    uint8_t j;
+    for (j = 0; (j < 8) && !bins[k + j]; ++j) {}
+    if (j == 8) continue;
+    LineRecord<LINE_HIST_MAX> r;
+    r.put_dec(k);
+    for (j = 0; j < 8; ++j) {
+      r.put(' ');
+      r.put_dec(bins[k + j]);
+    }
+    r.put(tag, sizeof(tag) - 1);
+    r.send(OUT_DATA_NO_CHANNEL);
+  }
+  LineRecord<LINE_HIST_MAX> r;
+  r.put_dec(pairs);
+  r.put(' ');
+  r.put_dec(under);
+  r.put(' ');
+  r.put_dec(over);
+  r.put(tag, sizeof(tag) - 1);
+  r.send(OUT_DATA_NO_CHANNEL);
+}
@@ -0,0 +1,35 @@
+#ifndef HIST_H
+#define HIST_H
+
+// hist.h -- on-board time interval histogram
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+// In Histogram mode the A->B interval of the first channel pair is not
+// sent; it is counted into HIST_BINS bins of config.HIST_WIDTH ps, the
+// first starting at config.HIST_LO ps, with intervals below and above
+// the range counted apart.  The counts go out as text, whatever
+// config.FORMAT is, every config.HIST_GATE pairs (then start again from
+// zero) and on '?' from the host (without clearing):
+//   <k> <count k> .. <count k+7> H(A->B)    for each group of 8 bins
+//                                           with any counts
+//   <pairs> <under> <over> H(A->B)          closes the histogram
+// so a gate costs a few hundred bytes however fast the pairs come in.
+
+#include <stdint.h>
+
+#ifndef HIST_BINS
+#define HIST_BINS  64         // multiple of 8; 4 bytes each
+#endif
+
+// SplitTime comes from misc.h, which must be included first
+
+void hist_reset();
+// Count one interval; sends and clears the histogram at gate end
+void hist_add(const SplitTime &d);
+void hist_report();
+
+#endif  /* HIST_H */
@@ -15,6 +15,8 @@
 #include "board.h"            // Arduino pin definitions
 #include "config.h"           // config and eeprom
 #include "tdc7200.h"          // TDC registers and structures
+#include "uart0.h"            // USART0 driver; remaps Serial
+#include "output.h"           // record output and overload policy
 
 /*
  * Printing rationale (summary):
@@ -149,6 +151,9 @@ static inline char * bufAppendU32Padded(char *p, const char *end, uint32_t v, ui
   while (n--) { if (p < end) *p++ = tmp[n]; }
   return p;
 }
+size_t formatU32(char *buf, size_t cap, uint32_t v, uint8_t width) {
+  return (size_t)(bufAppendU32Padded(buf, buf + cap, v, width) - buf);
+}
 static inline char * bufAppendSecondsWrapped(char *p, const char *end, int32_t sec, int32_t wrap) {
   if (wrap <= 0) {
     // simple itoa
@@ -369,6 +374,31 @@ SplitTime absDeltaSplit(const SplitTime &b, const SplitTime &a) {
   return d;
 }
 
+int64_t splitToPs(const SplitTime &t) {
+  // the common small cases with one 32x32 multiply
+  if (t.sec == 0) {
+    return (int64_t)((uint64_t)t.frac_hi * 1000000UL + t.frac_lo);
+  }
+  if (t.sec == -1) {
+    return -(int64_t)((uint64_t)(999999UL - t.frac_hi) * 1000000UL + (1000000UL - t.frac_lo));
+  }
+  return (int64_t)t.sec * 1000000000000LL + (int64_t)t.frac_hi * 1000000LL + t.frac_lo;
+}
+
+SplitTime psToSplit(int64_t ps) {
+  SplitTime t;
+  int64_t sec = ps / 1000000000000LL;
+  int64_t rem = ps % 1000000000000LL;
+  if (rem < 0) {
+    rem += 1000000000000LL;
+    sec -= 1;
+  }
+  t.sec = (int32_t)sec;
+  t.frac_hi = (uint32_t)(rem / 1000000LL);
+  t.frac_lo = (uint32_t)(rem % 1000000LL);
+  return t;
+}
+
 void printTimestampSplit(const SplitTime &t, int places, int32_t wrap) {
   // integer seconds
   int32_t sec = t.sec;
@@ -409,12 +439,319 @@ void printSignedSplit(const SplitTime &t, int places) {
   serialPrintFrac(hi, lo, (uint8_t)places);
 }
 
-// Append CRLF and write out buffer in a single Serial.write().
-// Assumes buf has at least 64 bytes capacity; caps total length at 64.
-void writeln64(char *buf, size_t n) {
+// Append CRLF and queue the buffer as one record.  Nothing is cut
+// short: the caller must leave room after the n bytes for the CRLF.
+void writeln(char *buf, size_t n, uint8_t ch) {
   if (!buf) return;
-  if (n > 62) n = 62; // leave space for CRLF
   buf[n++] = '\r';
   buf[n++] = '\n';
-  Serial.write((const uint8_t*)buf, n);
+  out_record(ch, (const uint8_t*)buf, n);
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), a byte at a time
+// without a table
+uint16_t crc16_ccitt(const uint8_t *p, size_t n) {
+  uint16_t crc = 0xFFFF;
+  while (n--) {
+    uint8_t x = (uint8_t)(crc >> 8) ^ *p++;
+    x ^= x >> 4;
+    crc = (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+  }
+  return crc;
+}
+
+// COBS-encode n (< 254) bytes into out, which needs n + 2 bytes; the
+// trailing 0x00 delimiter is included in the returned length
+size_t cobs_encode(const uint8_t *in, size_t n, uint8_t *out) {
+  size_t code_at = 0, o = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < n; ++i) {
+    if (in[i] == 0) {
+      out[code_at] = code;
+      code_at = o++;
+      code = 1;
+    } else {
+      out[o++] = in[i];
+      code++;
+    }
+  }
+  out[code_at] = code;
+  out[o++] = 0x00;
+  return o;
+}
+
+// Build, frame and send one binary record (layout in misc.h)
+// Add the CRC to bytes 0..11 of rec and queue it as one frame
+static bool sendBinary(uint8_t *rec, uint8_t ch) {
+  uint8_t frame[BIN_FRAME_MAX];
+  uint16_t crc = crc16_ccitt(rec, BIN_RECORD_LEN - 2);
+  rec[12] = (uint8_t)crc;
+  rec[13] = (uint8_t)(crc >> 8);
+  return out_record(ch, frame, cobs_encode(rec, BIN_RECORD_LEN, frame));
+}
+
+void writeBinary(uint8_t type, uint8_t ch, uint16_t seq, const SplitTime &t) {
+  uint8_t rec[BIN_RECORD_LEN];
+  uint32_t sec = (uint32_t)t.sec;
+
+  rec[0] = (uint8_t)((type << 4) | (ch & 0x0F));
+  rec[1] = (uint8_t)seq;
+  rec[2] = (uint8_t)(seq >> 8);
+  rec[3] = (uint8_t)sec;
+  rec[4] = (uint8_t)(sec >> 8);
+  rec[5] = (uint8_t)(sec >> 16);
+  rec[6] = (uint8_t)(sec >> 24);
+  rec[7] = (uint8_t)t.frac_lo;
+  rec[8] = (uint8_t)(t.frac_lo >> 8);
+  rec[9] = (uint8_t)(((t.frac_lo >> 16) & 0x0F) | ((t.frac_hi & 0x0F) << 4));
+  rec[10] = (uint8_t)(t.frac_hi >> 4);
+  rec[11] = (uint8_t)(t.frac_hi >> 12);
+  sendBinary(rec, ch);
+}
+
+bool writeOverrun(uint8_t ch, uint32_t queue, uint32_t timeouts) {
+  uint8_t rec[BIN_RECORD_LEN];
+  rec[0] = (uint8_t)((BIN_TYPE_OVERRUN << 4) | (ch & 0x0F));
+  rec[1] = 0;
+  rec[2] = 0;
+  for (uint8_t k = 0; k < 4; ++k) {
+    rec[3 + k] = (uint8_t)(queue >> (8 * k));
+    rec[7 + k] = (uint8_t)(timeouts >> (8 * k));
+  }
+  rec[11] = 0;
+  return sendBinary(rec, OUT_NO_CHANNEL);   // a report, not a data record
+}
+
+// 128-bit helpers.  Multiplies go through 32x32 partial products, and
+// divide and square root are bit at a time; both run once per gate or
+// report, not per event.
+
+void u128_add(U128 *a, const U128 &b) {
+  uint64_t l = a->lo + b.lo;
+  a->hi += b.hi + (l < b.lo);
+  a->lo = l;
+}
+
+void u128_sub(U128 *a, const U128 &b) {
+  a->hi -= b.hi + (a->lo < b.lo);
+  a->lo -= b.lo;
+}
+
+bool u128_lt(const U128 &a, const U128 &b) {
+  return (a.hi < b.hi) || ((a.hi == b.hi) && (a.lo < b.lo));
+}
+
+U128 u128_mul64(uint64_t a, uint64_t b) {
+  U128 r;
+  if (!((a | b) >> 32)) {     // the usual case for ps deviations
+    r.hi = 0;
+    r.lo = a * b;
+    return r;
+  }
+  uint64_t al = (uint32_t)a, ah = a >> 32;
+  uint64_t bl = (uint32_t)b, bh = b >> 32;
+  uint64_t p0 = al * bl, p1 = al * bh, p2 = ah * bl, p3 = ah * bh;
+  uint64_t mid = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+  r.lo = (mid << 32) | (uint32_t)p0;
+  r.hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+  return r;
+}
+
+U128 u128_mul32(const U128 &a, uint32_t b) {
+  U128 r = u128_mul64(a.lo, b);
+  r.hi += a.hi * b;
+  return r;
+}
+
+U128 u128_shl(U128 a, uint8_t n) {
+  if (n) {
+    a.hi = (a.hi << n) | (a.lo >> (64 - n));
+    a.lo <<= n;
+  }
+  return a;
+}
+
+U128 u128_shr(U128 a, uint8_t n) {
+  if (n) {
+    a.lo = (a.lo >> n) | (a.hi << (64 - n));
+    a.hi >>= n;
+  }
+  return a;
+}
+
+U128 u128_div64(U128 a, uint64_t d) {
+  U128 q = {0, 0};
+  uint64_t rem = 0;
+  for (uint8_t i = 0; i < 128; ++i) {
+    bool carry = rem >> 63;
+    rem = (rem << 1) | (a.hi >> 63);
+    a = u128_shl(a, 1);
+    q = u128_shl(q, 1);
+    if (carry || (rem >= d)) {
+      rem -= d;
+      q.lo |= 1;
+    }
+  }
+  return q;
+}
+
+uint64_t u128_isqrt(U128 a) {
+  U128 res = {0, 0};
+  U128 bit = {(uint64_t)1 << 62, 0};
+  while (u128_lt(a, bit)) {
+    bit = u128_shr(bit, 2);
+    if (!bit.hi && !bit.lo) return 0;
+  }
+  while (bit.hi || bit.lo) {
+    U128 t = res;
+    u128_add(&t, bit);
+    res = u128_shr(res, 1);
+    if (!u128_lt(a, t)) {
+      u128_sub(&a, t);
+      u128_add(&res, bit);
+    }
+    bit = u128_shr(bit, 2);
+  }
+  return res.lo;
+}
+
+// num / den as d.ddde[+-]xx, in integers; den != 0
+size_t formatSci(char *buf, uint64_t num, uint64_t den) {
+  char *p = buf; const char *end = buf + 9;   // "d.ddde+xx"
+  if (!num) {
+    *p = '0';
+    return 1;
+  }
+  int8_t e = 0;
+  while (num / den < 1000) {
+    if (num <= UINT64_MAX / 10) num *= 10;
+    else den /= 10;
+    e--;
+  }
+  while (num / den >= 10000) {
+    if (den <= UINT64_MAX / 10) den *= 10;
+    else num /= 10;
+    e++;
+  }
+  uint64_t r = num % den;     // round half up without num + den / 2 overflowing
+  uint32_t q = (uint32_t)(num / den) + ((r >= den - r) ? 1 : 0);
+  if (q >= 10000) {
+    q /= 10;
+    e++;
+  }
+  e += 3;
+  p = bufAppendU32Padded(p, end, q / 1000, 1);
+  p = bufAppendChar(p, end, '.');
+  p = bufAppendU32Padded(p, end, q % 1000, 3);
+  p = bufAppendChar(p, end, 'e');
+  p = bufAppendChar(p, end, (e < 0) ? '-' : '+');
+  p = bufAppendU32Padded(p, end, (uint32_t)((e < 0) ? -e : e), 2);
+  return (size_t)(p - buf);
+}
+
+// Per-channel state for FORMAT 'D' (layout in misc.h)
+struct DeltaState {
+  SplitTime last;           // last timestamp sent
+  int64_t   last_d1;        // last first difference, ps
+  uint16_t  next_seq;       // sequence the next event must have to continue
+  uint16_t  since_sync;     // events since the last full record
+  uint32_t  dropped;        // out_dropped[] when the chain was last extended
+  uint32_t  started_ms;     // when the pending frame got its first event
+  uint16_t  first_seq;      // pending frame's first event
+  uint8_t   synced;         // chain valid; else next event is a full record
+  uint8_t   n;              // pending varint bytes
+  uint8_t   buf[DELTA_VARINT_BYTES];
+};
+static DeltaState delta[NUM_CHANNELS];
+
+// Send a channel's pending varints as one frame
+static void deltaSend(uint8_t ch) {
+  DeltaState &d = delta[ch];
+  if (!d.n) return;
+  uint8_t rec[DELTA_RECORD_MAX];
+  uint8_t frame[DELTA_RECORD_MAX + 2];
+  size_t len = 3 + d.n;
+
+  rec[0] = (uint8_t)((BIN_TYPE_DELTA << 4) | (ch & 0x0F));
+  rec[1] = (uint8_t)d.first_seq;
+  rec[2] = (uint8_t)(d.first_seq >> 8);
+  memcpy(rec + 3, d.buf, d.n);
+  uint16_t crc = crc16_ccitt(rec, len);
+  rec[len++] = (uint8_t)crc;
+  rec[len++] = (uint8_t)(crc >> 8);
+  d.n = 0;
+  if (!out_record(ch, frame, cobs_encode(rec, len, frame))) d.synced = 0;
+}
+
+void writeDelta(uint8_t ch, uint16_t seq, const SplitTime &t) {
+  DeltaState &d = delta[ch];
+  uint8_t v[7];
+  uint8_t vn = 0;
+
+  // a dropped record of this channel, even one already queued ('O'),
+  // breaks the chain
+  if (out_dropped[ch] != d.dropped) {
+    d.dropped = out_dropped[ch];
+    d.synced = 0;
+  }
+
+  if (d.synced && (seq == d.next_seq) && (d.since_sync < DELTA_RESYNC)) {
+    SplitTime dt = diffSplit(t, d.last);
+    if ((dt.sec >= -2) && (dt.sec < 2)) {
+      int64_t d1 = (int64_t)dt.sec * 1000000000000LL +
+                   (int64_t)dt.frac_hi * 1000000LL + dt.frac_lo;
+      int64_t d2 = d1 - d.last_d1;
+      if ((d2 > -((int64_t)1 << 41)) && (d2 < ((int64_t)1 << 41))) {
+        // zigzag then LEB128: at most 42 bits, so 6 bytes
+        uint64_t z = ((uint64_t)d2 << 1) ^ (uint64_t)(d2 >> 63);
+        while (z >= 0x80) {
+          v[vn++] = (uint8_t)z | 0x80;
+          z >>= 7;
+        }
+        v[vn++] = (uint8_t)z;
+        d.last_d1 = d1;
+      }
+    }
+  }
+
+  if (vn && (d.n + vn > DELTA_VARINT_BYTES)) {
+    deltaSend(ch);
+    if (!d.synced) vn = 0;  // that frame was dropped
+  }
+  if (vn) {
+    if (!d.n) {
+      d.first_seq = seq;
+      d.started_ms = millis();
+    }
+    memcpy(d.buf + d.n, v, vn);
+    d.n += vn;
+    d.since_sync++;
+  } else {
+    deltaSend(ch);  // keep the channel's events in order
+    writeBinary(BIN_TYPE_TIMESTAMP, ch, seq, t);
+    d.synced = 1;
+    d.last_d1 = 0;
+    d.since_sync = 0;
+  }
+  d.last = t;
+  d.next_seq = (uint16_t)(seq + 1);
+  // a drop of the frame or full record just sent shows up on the next
+  // event's check above
+}
+
+void deltaPoll(bool force) {
+  uint32_t now = millis();
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ++ch) {
+    if (delta[ch].n && (force || (now - delta[ch].started_ms) >= DELTA_MAX_AGE_MS)) {
+      deltaSend(ch);
+    }
+  }
+}
+
+void deltaReset() {
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ++ch) {
+    delta[ch].n = 0;
+    delta[ch].synced = 0;
+    delta[ch].dropped = out_dropped[ch];
+  }
 }
@@ -26,6 +26,26 @@ SplitTime diffSplit(const SplitTime &b, const SplitTime &a);
 // Return |b - a| as a non-negative SplitTime
 SplitTime absDeltaSplit(const SplitTime &b, const SplitTime &a);
 
+// Conversions to and from signed ps; |t| must stay under 106 days
+int64_t splitToPs(const SplitTime &t);
+SplitTime psToSplit(int64_t ps);
+
+// Unsigned 128-bit arithmetic for the statistics accumulators
+// (aggregate.cpp, adev.cpp, freq.cpp); only what they need
+struct U128 {
+  uint64_t hi;
+  uint64_t lo;
+};
+void u128_add(U128 *a, const U128 &b);
+void u128_sub(U128 *a, const U128 &b);          // a >= b
+bool u128_lt(const U128 &a, const U128 &b);
+U128 u128_mul64(uint64_t a, uint64_t b);
+U128 u128_mul32(const U128 &a, uint32_t b);     // a * b must fit
+U128 u128_shl(U128 a, uint8_t n);               // n < 64
+U128 u128_shr(U128 a, uint8_t n);               // n < 64
+U128 u128_div64(U128 a, uint64_t d);            // floor(a / d), d != 0
+uint64_t u128_isqrt(U128 a);                    // floor(sqrt(a))
+
 // Printing helpers for SplitTime
 void printTimestampSplit(const SplitTime &t, int places, int32_t wrap);
 void printSignedSplit(const SplitTime &t, int places);
@@ -41,6 +61,72 @@ void print_signed_sec_frac(int64_t sec, int64_t frac_ps, int places);
 size_t formatTimestampSplitTo(char *buf, size_t cap, const SplitTime &t, int places, int32_t wrap);
 size_t formatSignedSplitTo(char *buf, size_t cap, const SplitTime &t, int places);
 size_t formatTimeDifference(char *buf, size_t cap, const SplitTime &diff, int places);
+// v in decimal, zero-padded to at least width digits, as put_dec()
+// does for a LineRecord (record.h)
+size_t formatU32(char *buf, size_t cap, uint32_t v, uint8_t width);
+// num / den as d.ddde[+-]xx (four significant digits); den != 0
+size_t formatSci(char *buf, uint64_t num, uint64_t den);
+
+// Append CRLF to the n bytes in buf, which must have room for them, and
+// queue the line as channel ch's record (see output.h).  Data lines use
+// LineRecord (record.h) instead.
+void writeln(char *buf, size_t n, uint8_t ch);
+
+// Binary output (FORMAT 'B').  Each result is one fixed 14-byte record,
+// COBS-encoded and terminated by a 0x00 delimiter (16 bytes on the wire):
+//   [0]      type (BIN_TYPE_*) in bits 4-7, channel or pair in bits 0-3
+//   [1..2]   sequence, low 16 bits of the channel's seq(), LE
+//   [3..6]   int32 seconds, LE
+//   [7..11]  fraction, frac_lo in bits 0-19 and frac_hi in bits 20-39, LE
+//   [12..13] CRC-16/CCITT-FALSE of bytes 0..11, LE
+// The value is always sec + fraction, so a negative interval has a
+// negative sec and a positive fraction, as diffSplit() returns it.
+// Frames are under 34 bytes, so no frame starts with '#' and text
+// comment lines can still be told apart from frames.
+#define BIN_TYPE_TIMESTAMP        1
+#define BIN_TYPE_INTERVAL         2   // channel field is the first channel of the pair
+#define BIN_TYPE_PERIOD           3
+#define BIN_RECORD_LEN            14
+#define BIN_FRAME_MAX             (BIN_RECORD_LEN + 2)  // COBS code byte and delimiter
+
+// With config.SEQUENCE 'Y' the "# overrun" report (output.h) is sent in
+// the same 14-byte form, so a binary stream carries no text at run time:
+//   [0]      BIN_TYPE_OVERRUN in bits 4-7, channel in bits 0-3
+//   [1..2]   0
+//   [3..6]   uint32 records dropped by the overload policy, LE
+//   [7..10]  uint32 TDC timeouts, LE
+//   [11]     0
+//   [12..13] CRC-16/CCITT-FALSE of bytes 0..11, LE
+// Both counts are running totals since out_reset().
+#define BIN_TYPE_OVERRUN          5
+
+uint16_t crc16_ccitt(const uint8_t *p, size_t n);
+size_t cobs_encode(const uint8_t *in, size_t n, uint8_t *out);
+void writeBinary(uint8_t type, uint8_t ch, uint16_t seq, const SplitTime &t);
+bool writeOverrun(uint8_t ch, uint32_t queue, uint32_t timeouts);  // false if dropped
+
+// Delta output (FORMAT 'D', Timestamp mode).  A channel's timestamps go
+// out as second differences in ps: d1 = t - t_prev, d2 = d1 - d1_prev,
+// zigzag-mapped and packed as LEB128 varints, several per frame:
+//   [0]      BIN_TYPE_DELTA in bits 4-7, channel in bits 0-3
+//   [1..2]   sequence of the frame's first event, LE; the rest follow
+//            with no gaps
+//   [3..]    one varint per event
+//   [last 2] CRC-16/CCITT-FALSE of the bytes before it, LE
+// d1_prev is 0 after a full record, which is a FORMAT 'B' timestamp
+// record.  A full record is sent for the first event, every DELTA_RESYNC
+// events, after a sequence gap or a dropped frame, and when |d2| is too
+// big to be worth a varint; a frame goes out when it is full or has
+// waited DELTA_MAX_AGE_MS.  A steady 1 kHz input whose second
+// differences stay under 64 ps costs about 1.4 bytes an event on the
+// wire, against 16 for 'B' and 24 or so for a text line.  Other modes
+// send 'B' records when FORMAT is 'D'.
+#define BIN_TYPE_DELTA            4
+#define DELTA_VARINT_BYTES        20  // varint space per frame
+#define DELTA_RECORD_MAX          (3 + DELTA_VARINT_BYTES + 2)
+#define DELTA_RESYNC              256 // events between full records
+#define DELTA_MAX_AGE_MS          100
 
-// Append CRLF to a buffer (capped at 64 total) and write via Serial.write()
-void writeln64(char *buf, size_t n);
+void writeDelta(uint8_t ch, uint16_t seq, const SplitTime &t);
+void deltaPoll(bool force);   // send frames that are due, or all of them
+void deltaReset();            // next event on every channel is a full record
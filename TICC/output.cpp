@@ -0,0 +1,209 @@
+// output.cpp -- measurement record output and overload handling
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"           // config and eeprom
+#include "misc.h"             // binary overrun records
+#include "output.h"
+#include "record.h"           // output line builder
+#include "uart0.h"            // USART0 driver; remaps Serial
+
+extern config_t config;
+
+uint32_t out_dropped[NUM_CHANNELS];
+uint32_t out_dropped_other;
+
+// Records written to the TX ring and maybe not yet sent, oldest first.
+// Their total length is listed; the ring itself holds queued() unsent
+// bytes, so a record is wholly unsent when it and everything after it
+// add up to no more than that.
+struct OutRecord {
+  uint8_t len;
+  uint8_t ch;
+};
+static OutRecord recs[OUT_MAX_RECORDS];
+static uint8_t rec_first;             // index of the oldest record
+static uint8_t rec_count;
+static uint16_t listed;               // sum of recs[].len
+
+static uint16_t decim[NUM_CHANNELS];  // records since the last one 'D' passed
+static uint32_t reported;             // drop total at the last report
+static uint32_t seen_dropped[NUM_CHANNELS];   // counts in the last overrun record
+static uint32_t seen_timeouts[NUM_CHANNELS];
+static uint32_t seen_other;
+static uint32_t last_report_ms;
+
+// "# overrun chX queue <n> timeout <n>" and "# dropped A:<n> ... other:<n>"
+#define LINE_OVERRUN_MAX  (12 + 1 + 7 + 9 + 2 * REC_U32_LEN + REC_EOL_LEN)
+#define LINE_DROPPED_MAX  (9 + NUM_CHANNELS * (3 + REC_U32_LEN) + 7 + REC_U32_LEN + REC_EOL_LEN)
+
+static inline uint8_t rec_at(uint8_t k) {
+  return (uint8_t)((rec_first + k) % OUT_MAX_RECORDS);
+}
+
+static void count_drop(uint8_t ch) {
+  if (ch < NUM_CHANNELS) out_dropped[ch]++;
+  else if (ch == OUT_DATA_NO_CHANNEL) out_dropped_other++;
+}
+
+// Forget records that have gone out completely
+static void prune(uint16_t unsent) {
+  while (rec_count && (listed - recs[rec_first].len >= unsent)) {
+    listed -= recs[rec_first].len;
+    rec_first = rec_at(1);
+    rec_count--;
+  }
+}
+
+// Drop the oldest record nothing of which has been sent; false if none
+static bool drop_oldest() {
+  uint16_t unsent = Serial.queued();
+  prune(unsent);
+  if (!rec_count) return false;
+
+  uint8_t k = (listed <= unsent) ? 0 : 1;  // record 0 may be under way
+  if (k >= rec_count) return false;     // only the partial one is left
+  uint16_t newer = listed;
+  for (uint8_t j = 0; j <= k; ++j) newer -= recs[rec_at(j)].len;
+  OutRecord r = recs[rec_at(k)];
+  if (!Serial.unqueue(newer, r.len)) return false;
+
+  if (k) recs[rec_at(1)] = recs[rec_first];  // keep the partial one
+  rec_first = rec_at(1);
+  rec_count--;
+  listed -= r.len;
+  count_drop(r.ch);
+  return true;
+}
+
+bool out_record(uint8_t ch, const uint8_t *buf, size_t n) {
+  uint16_t room = (uint16_t)Serial.availableForWrite();
+
+  switch (config.OVERLOAD) {
+    case 'N':
+      break;
+    case 'O':
+      while ((room < n) && drop_oldest()) {
+        room = (uint16_t)Serial.availableForWrite();
+      }
+      break;
+    case 'D':
+      if ((ch < NUM_CHANNELS) && (Serial.queued() > UART0_TX_SIZE / 2)) {
+        if (++decim[ch] < config.OVERLOAD_N) {
+          count_drop(ch);
+          return false;
+        }
+        decim[ch] = 0;
+      }
+      break;
+    default:  // 'B'
+      room = (uint16_t)n;  // write() waits for room
+      break;
+  }
+  if (room < n) {
+    count_drop(ch);
+    return false;
+  }
+
+  // track it for 'O'; if the list is full the oldest entries are
+  // forgotten, which only means they can't be dropped any more
+  if (rec_count == OUT_MAX_RECORDS) {
+    listed -= recs[rec_first].len;
+    rec_first = rec_at(1);
+    rec_count--;
+  }
+  recs[rec_at(rec_count)].len = (uint8_t)n;
+  recs[rec_at(rec_count)].ch = ch;
+  rec_count++;
+  listed += (uint16_t)n;
+  Serial.write(buf, n);
+  return true;
+}
+
+// config.SEQUENCE: one record per channel with new losses.  A channel's
+// counts are only taken as reported once its record got into the ring.
+static void report_overruns(uint32_t now, uint32_t (*timeouts)(uint8_t ch)) {
+  for (uint8_t i = 0; i < NUM_CHANNELS; ++i) {
+    uint32_t d = out_dropped[i], t = timeouts(i);
+    if ((d == seen_dropped[i]) && (t == seen_timeouts[i])) continue;
+    if (config.FORMAT != 'A') {
+      if (!writeOverrun(i, d, t)) return;
+    } else {
+      LineRecord<LINE_OVERRUN_MAX> r;
+      r.put("# overrun ch", 12);
+      r.put(config.NAME[i]);
+      r.put(" queue ", 7);
+      r.put_dec(d);
+      r.put(" timeout ", 9);
+      r.put_dec(t);
+      if (!r.send(OUT_NO_CHANNEL)) return;
+    }
+    seen_dropped[i] = d;
+    seen_timeouts[i] = t;
+    last_report_ms = now;
+  }
+  if (out_dropped_other != seen_other) {
+    uint32_t d = out_dropped_other;
+    LineRecord<LINE_OVERRUN_MAX> r;
+    r.put("# overrun other queue ", 22);
+    r.put_dec(d);
+    if (!r.send(OUT_NO_CHANNEL)) return;
+    seen_other = d;
+    last_report_ms = now;
+  }
+}
+
+void out_report(uint32_t (*timeouts)(uint8_t ch)) {
+  if (config.SEQUENCE == 'Y') {
+    uint32_t now = millis();
+    if ((now - last_report_ms) >= 1000) report_overruns(now, timeouts);
+    return;
+  }
+
+  uint32_t total = out_dropped_other;
+  for (size_t i = 0; i < NUM_CHANNELS; ++i) total += out_dropped[i];
+  if (total == reported) return;
+  uint32_t now = millis();
+  if ((now - last_report_ms) < 1000) return;
+
+  LineRecord<LINE_DROPPED_MAX> r;
+  r.put("# dropped", 9);
+  for (size_t i = 0; i < NUM_CHANNELS; ++i) {
+    r.put(' ');
+    r.put(config.NAME[i]);
+    r.put(':');
+    r.put_dec(out_dropped[i]);
+  }
+  if (out_dropped_other) {
+    r.put(" other:", 7);
+    r.put_dec(out_dropped_other);
+  }
+  if (r.send(OUT_NO_CHANNEL)) {
+    reported = total;
+    last_report_ms = now;
+  }
+}
+
+void out_flush() {
+  Serial.flush();
+  rec_count = 0;
+  listed = 0;
+}
+
+void out_reset() {
+  out_flush();
+  memset(out_dropped, 0, sizeof(out_dropped));
+  memset(seen_dropped, 0, sizeof(seen_dropped));
+  memset(seen_timeouts, 0, sizeof(seen_timeouts));
+  out_dropped_other = 0;
+  seen_other = 0;
+  memset(decim, 0, sizeof(decim));
+  reported = 0;
+  last_report_ms = millis();
+}
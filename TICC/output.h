@@ -0,0 +1,55 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+// output.h -- measurement record output and overload handling
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+// Every record loop() produces (text line, binary frame or raw record)
+// goes through out_record(), which applies config.OVERLOAD when the
+// serial TX ring (uart0.h) can't take it:
+//   'B' block until there is room (acquisition stalls; the old behavior)
+//   'N' drop the new record
+//   'O' drop the oldest records still waiting in the ring
+//   'D' decimate: while the ring is over half full, pass only every
+//       OVERLOAD_N-th record per channel; drop the new record if full
+// Drops are counted per channel and reported by out_report() in a
+// "# dropped" comment line at most once a second; an "other:<n>" field
+// is added once any OUT_DATA_NO_CHANNEL record has been lost.  Records are at most
+// 255 bytes.
+//
+// With config.SEQUENCE 'Y' data lines carry their channel's event number
+// (tdc7200Channel::seq(), which counts timeouts as well as completed
+// events), so a consumer sees any missing event as a gap, and
+// out_report() instead sends, for each channel that lost events since
+// the last one,
+//   # overrun chX queue <dropped> timeout <timeouts>
+// or, when config.FORMAT is 'B' or 'D', a BIN_TYPE_OVERRUN record
+// (misc.h) with the same counts, both running totals since out_reset().
+// Timeouts are measurements the TDC7200 ended without a result, as
+// counted in tdc7200Channel::timeouts and read through out_report()'s
+// argument; queue losses are records the overload policy dropped.
+// Lost OUT_DATA_NO_CHANNEL records are reported as
+//   # overrun other queue <dropped>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define OUT_NO_CHANNEL      0xFF  // comment records: never counted
+#define OUT_DATA_NO_CHANNEL 0xFE  // channel-less data (histogram lines): never
+                                  // decimated, drops go in out_dropped_other
+#define OUT_MAX_RECORDS     64    // records tracked in the TX ring for 'O'
+
+extern uint32_t out_dropped[];  // per-channel dropped records since out_reset()
+extern uint32_t out_dropped_other; // dropped OUT_DATA_NO_CHANNEL records
+
+bool out_record(uint8_t ch, const uint8_t *buf, size_t n);  // false if dropped
+// Call once per loop() pass; timeouts(ch) returns channel ch's timeout count
+void out_report(uint32_t (*timeouts)(uint8_t ch));
+void out_flush();               // drain the TX ring, e.g. before direct Serial output
+void out_reset();               // out_flush() and clear the counters
+
+#endif  /* OUTPUT_H */
@@ -0,0 +1,95 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+// record.h -- fixed-size text line builder for measurement output
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+// Data lines are built in a LineRecord<CAP> on the stack: fixed strings
+// (the precomputed " chA" / " TI(A->B)" tags) are copied in, counters
+// are converted by put_dec(), and the misc.h formatters write straight
+// into it through end() and room().  Nothing goes through the printf
+// engine.  send() adds CRLF and queues the line as one record
+// (output.h).  room() always leaves space for the CRLF, so a line that
+// fits its CAP is never cut short, and one that doesn't is truncated
+// instead of running past buf.
+//
+// The capacities below are worst cases built from the field widths, so
+// each mode's buffer size is fixed and checked at compile time.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "output.h"           // record output and overload policy
+
+#define REC_TIME_LEN    24    // "-2147483648.000000000000"
+#define REC_INT64_LEN   20    // "-9223372036854775808"
+#define REC_U32_LEN     10    // "4294967295"
+#define REC_CH_TAG_LEN  4     // " chA"
+#define REC_TI_TAG_LEN  9     // " TI(A->B)"
+#define REC_SEQ_LEN     (1 + REC_U32_LEN)   // config.SEQUENCE
+#define REC_EOL_LEN     2     // CRLF
+
+// Timestamp, Interval, Period and Frequency lines, and TimeLab's
+// " chC (int(B) + (B - A))"
+#define LINE_DATA_MAX   64
+// Debug: five TDC registers (up to 8 digits with their space), the cal
+// freshness flag, SPI transfers, PICstop, tof, the timestamp and the tag
+#define LINE_DEBUG_MAX  (5 * 9 + 2 + 4 + 2 * (REC_INT64_LEN + 1) + REC_TIME_LEN + \
+                         REC_CH_TAG_LEN + REC_SEQ_LEN + REC_EOL_LEN)
+
+static_assert(REC_TIME_LEN + 23 + REC_SEQ_LEN + REC_EOL_LEN <= LINE_DATA_MAX,
+              "TimeLab chC line does not fit LINE_DATA_MAX");
+static_assert(REC_TIME_LEN + REC_TI_TAG_LEN + REC_SEQ_LEN + REC_EOL_LEN <= LINE_DATA_MAX,
+              "interval line does not fit LINE_DATA_MAX");
+static_assert(LINE_DEBUG_MAX <= 255, "records are at most 255 bytes");
+
+template <size_t CAP>
+struct LineRecord {
+  char    buf[CAP];
+  uint8_t n;
+
+  LineRecord() : n(0) {}
+
+  char  *end()  { return buf + n; }
+  size_t room() const { return CAP - REC_EOL_LEN - n; }
+  void   grow(size_t k) { n += (uint8_t)((k < room()) ? k : room()); }
+
+  // put() and put_dec() stop at room(), so an oversized field is cut
+  // short rather than overrunning buf
+  void put(char c) {
+    if (room()) buf[n++] = c;
+  }
+  void put(const char *s, uint8_t len) {
+    if (len > room()) len = (uint8_t)room();
+    memcpy(buf + n, s, len);
+    n += len;
+  }
+
+  // v in decimal, zero-padded to at least width (at most REC_U32_LEN) digits
+  void put_dec(uint32_t v, uint8_t width = 1) {
+    char t[REC_U32_LEN];
+    uint8_t k = 0;
+    if (width > REC_U32_LEN) width = REC_U32_LEN;
+    do {
+      t[k++] = (char)('0' + v % 10);
+      v /= 10;
+    } while (v);
+    while (k < width) t[k++] = '0';
+    uint8_t fit = (k < room()) ? k : (uint8_t)room();  // leading digits only
+    for (uint8_t j = 0; j < fit; ++j) buf[n + j] = t[k - 1 - j];
+    n += fit;
+  }
+
+  bool send(uint8_t ch) {  // false if the overload policy dropped it
+    buf[n++] = '\r';
+    buf[n++] = '\n';
+    return out_record(ch, (const uint8_t *)buf, n);
+  }
+};
+
+#endif  /* RECORD_H */
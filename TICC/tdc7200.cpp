@@ -29,17 +29,60 @@ tdc7200Channel::tdc7200Channel(char id, int enable, int intb, int csb, int stop,
 	pinMode(CSB,OUTPUT);
 	pinMode(STOP,INPUT);
   pinMode(LED, OUTPUT);
+  flush_state = FLUSH_IDLE;
+  start_edge = 'R';
+  timeouts = 0;
+  shadow_valid = 0;
+  spi_xfers = 0;
 };
 
-// TDC7200 configure
+// Drive ENABLE; a low-to-high transition resets and enables the chip
+void tdc7200Channel::tdc_power(bool on) {
+  digitalWrite(ENABLE, on ? HIGH : LOW);
+  if (on) invalidate_shadow();  // chip registers are back at their reset defaults
+}
+
+// Wait for COARSE to go low to align phase before configuring.  Bounded
+// so a missing 10 MHz reference can't hang setup; the reference-lost
+// check in loop() reports that case.
+static void tdc_align_coarse() {
+  // TODO: check whether this is necessary; may be cruft from early testing
+  uint32_t start = micros();
+  boolean state = true;
+  boolean last_state = true;
+  while (state || last_state) { // catch COARSE falling edge tO align phase
+    last_state = state;
+    state = digitalRead(COARSEint);
+    if ((uint32_t)(micros() - start) > TDC_ALIGN_TIMEOUT_US) break;
+    }
+}
+
+// TDC7200 configure (this chip only)
 void tdc7200Channel::tdc_setup() {
+  tdc_power(false);
+  delay(TDC_ENABLE_LOW_MS);  
+  tdc_power(true);  // Needs a low-to-high transition to enable
+  delay(TDC_LDO_SETTLE_MS);  // 1.5ms minimum recommended to allow chip LDO to stabilize
+  tdc_align_coarse();
+  tdc_configure();
+}
+
+// Set up several chips at once: one shared ENABLE pulse and LDO settle
+// time, one phase alignment, then program each chip back-to-back
+void tdc_setup_all(tdc7200Channel *chans, size_t n) {
+  size_t i;
+  for (i = 0; i < n; ++i) chans[i].tdc_power(false);
+  delay(TDC_ENABLE_LOW_MS);
+  for (i = 0; i < n; ++i) chans[i].tdc_power(true);
+  delay(TDC_LDO_SETTLE_MS);  // 1.5ms minimum recommended to allow chip LDO to stabilize
+  tdc_align_coarse();
+  for (i = 0; i < n; ++i) chans[i].tdc_configure();
+}
+
+// Program the registers; the chip must already be enabled
+void tdc7200Channel::tdc_configure() {
   byte CALIBRATION2_PERIODS = 0x80;  // default to 20 periods
   byte AVG_CYCLES, NUM_STOP;
-   
-  digitalWrite(ENABLE, LOW);
-  delay(5);  
-  digitalWrite(ENABLE, HIGH);  // Needs a low-to-high transition to enable
-  delay(5);  // 1.5ms minimum recommended to allow chip LDO to stabilize
 
   switch (CAL_PERIODS) { // convert actual cal periods to bitmask
     case  2: CALIBRATION2_PERIODS = 0x00; break;
@@ -54,13 +97,6 @@ void tdc7200Channel::tdc_setup() {
 
   config_byte2 = CALIBRATION2_PERIODS | AVG_CYCLES | NUM_STOP;
 
-  // TODO: check whether this is necessary; may be cruft from early testing
-  boolean state = true;
-  boolean last_state = true;
-  while (state || last_state) { // catch COARSE falling edge tO align phase
-    last_state = state;
-    state = digitalRead(COARSEint);
-    }
   write(CONFIG2, config_byte2);
 
   // enable interrupts:
@@ -75,10 +111,9 @@ void tdc7200Channel::tdc_setup() {
   // See comment above -- setting CLOCK_CNTR_OVF to 0x05, 0x00 provides
   // a reasonable timeout after measurement completes.
   // When this occurs, INTB is set and the chip returns.
-  
-  //clock counter overflow occurs when clock_countN > mask
-  write(CLOCK_CNTR_OVF_H, config.TIMEOUT);     // default is 0xFF
-  write(CLOCK_CNTR_OVF_L, 0x00);     // default is 0xFF
+  // In adaptive mode this is the ceiling; see track_timeout().
+  reset_timeout();
+  write_ovf();     // default is 0xFFFF
 
   // now build config1 register byte
   // sets trigger edge
@@ -92,10 +127,7 @@ void tdc7200Channel::tdc_setup() {
   
   // set trigger edge
   byte START_EDGE = 0x00;  // START default 0x00 for rising edge; falling edge would be 0x08
-  if ( (ID == '0') && (config.START_EDGE[0] == 'F') ) {
-    START_EDGE = 0x08;
-    }
-  if ( (ID == '1') && (config.START_EDGE[1] == 'F') ) {
+  if (start_edge == 'F') {
     START_EDGE = 0x08;
     }
 
@@ -110,10 +142,11 @@ void tdc7200Channel::tdc_setup() {
   tdc_ack_int();
   }
 
-// Acknowledge interrupts
+// Acknowledge interrupts.  INT_STATUS bits are write-1-to-clear and
+// writing 1 to a flag that isn't set is harmless, so clear them all
+// blind (as TI's reference code does) rather than read-modify-write.
 void tdc7200Channel::tdc_ack_int() {
-  uint8_t intstat = readReg8(INT_STATUS);
-  write(INT_STATUS, intstat);
+  write(INT_STATUS, INT_STATUS_ALL);
 }
 
 // Enable next measurement cycle
@@ -121,26 +154,50 @@ void tdc7200Channel::ready_next() {
   write(CONFIG1, config_byte1);
   }
 
-// Flush partial measurements and reset TDC7200 state
-void tdc7200Channel::flush_and_reset() {
-  // Acknowledge any pending interrupts to clear them
-  tdc_ack_int();
-  
+// Begin flushing partial measurements.  Stops the chip and arms the
+// flush state machine; poll_flush() finishes the job once the chip is
+// idle, so several channels can be flushed in parallel.
+void tdc7200Channel::begin_flush() {
   // Stop current measurement by clearing START_MEAS bit
-  byte stop_config = config_byte1 & ~0x01;  // Clear START_MEAS bit
+  byte stop_config = config_byte1 & ~START_MEAS_BIT;  // Clear START_MEAS bit
   write(CONFIG1, stop_config);
-  
-  // Wait a moment for any in-progress measurement to complete
-  delay(10);
-  
-  // Acknowledge interrupts again to clear any that occurred during stop
+
+  flush_state = FLUSH_WAIT;
+  flush_start_us = micros();
+}
+
+// Advance the flush state machine; returns true once the flush is done.
+// The chip is idle when no measurement has started or the started one
+// has completed (or timed out via CLOCK_CNTR_OVF).  FLUSH_TIMEOUT_US is
+// only a safety cap in case INT_STATUS never settles.
+bool tdc7200Channel::poll_flush() {
+  if (flush_state == FLUSH_IDLE) return true;
+
+  byte intstat = readReg8(INT_STATUS);
+  bool busy = (intstat & MEAS_STARTED_FLAG) && !(intstat & MEAS_COMPLETE_FLAG);
+  if (busy && ((uint32_t)(micros() - flush_start_us) < FLUSH_TIMEOUT_US)) {
+    return false;
+  }
+
+  // Acknowledge everything that happened before and during the stop
   tdc_ack_int();
   
-  // Re-enable measurement for next cycle
-  ready_next();
-
   // Reset channel state variables
   reset_channel_state();
+
+  // Program the (possibly reset) timeout, then re-enable measurement
+  write_ovf();
+  ready_next();
+
+  flush_state = FLUSH_IDLE;
+  return true;
+}
+
+// Flush partial measurements and reset TDC7200 state (blocking until
+// the chip is idle, normally a single INT_STATUS read)
+void tdc7200Channel::flush_and_reset() {
+  begin_flush();
+  while (!poll_flush()) { /* spin on chip state */ }
 }
 
 // Reset channel state variables without hardware reset
@@ -155,6 +212,7 @@ void tdc7200Channel::reset_channel_state() {
   
   // Clear timestamp data
   tof = 0;
+  tof_is_split = 0;
   last_tof = 0;
   new_ts_ready = 0;
   ts_split.sec = 0;
@@ -164,22 +222,269 @@ void tdc7200Channel::reset_channel_state() {
   last_ts_split.frac_hi = 0;
   last_ts_split.frac_lo = 0;
   
+  // Drop cached calibration and force the fixed-point LSB to be rebuilt
+  // (time_dilation or the calibration settings may have changed)
+  reset_cal();
+  lsb_cal_diff = 0;
+  lsb_q24 = 0;
+
   // Reset coarse-time cache
   last_picstop = 0;
   cached_sec = 0;
   cached_rem_ticks = 0;
+
+  // Restart timeout learning from the configured ceiling
+  reset_timeout();
   
-  // Note: We deliberately do NOT reset totalize counter or PICstop
+  // Note: We deliberately do NOT reset totalize/timeouts counters or PICstop
   // as these should maintain continuity across config changes
 }
 
-// Read TDC
-int64_t tdc7200Channel::read() {
-  int64_t normLSB;
+// Fetch raw results from the TDC.  This is the only part of the
+// per-event work that needs the chip; once it returns the channel
+// can be re-armed with ready_next() and compute_tof() run while the
+// next measurement window is already open.
+//
+// Returns false if the measurement ended in a counter overflow (a
+// missed STOP); there is no valid result then and the caller should
+// just re-arm.
+bool tdc7200Channel::fetch() {
+  // The chip can't produce another STOP until it is re-armed, so
+  // PICstop is stable here; latch it so the ISR may overwrite the
+  // live copy while we are still doing the math.
+  PICstop_latched = PICstop;
+  spi_xfers = 0;
+
+  // The measurement is complete, so the chip has cleared START_MEAS
+  shadow[CONFIG1] &= ~START_MEAS_BIT;
+
+  // Find out why INTB fired: a result or a timeout.  This costs its own
+  // transaction; INT_STATUS (0x02, 8 bits) can't join the TIME1 burst.
+  int_status = readReg8(INT_STATUS);
+  if (int_status & (COARSE_CNTR_OVF_INT | CLOCK_CNTR_OVF_INT)) {
+    timeouts++;
+    // An adaptive limit that was too tight backs off to the ceiling at
+    // once and starts learning again
+    if (config.TIMEOUT_MODE == 'A') reset_timeout();
+    write_ovf();
+    tdc_ack_int();
+    return false;
+  }
+
+  // TIME1, CLOCK_COUNT1 and TIME2 are adjacent; read them in one burst
+  uint32_t r[3];
+  readBurst24(TIME1, r, 3);
+  time1Result = r[0];    // START to next 100ns tick
+  clock1Result = r[1];   // number of 100ns ticks
+  time2Result = r[2];    // 100ns tick to STOP
+
+  // Learn the adaptive timeout here so it runs whatever the output
+  // format (Raw skips compute_tof())
+  if (config.TIMEOUT_MODE == 'A') {
+    track_timeout();
+  }
+
+  // Calibration barely moves between events; only fetch it when the
+  // cache is due for a refresh (every event if CAL_REFRESH <= 1)
+  cal_fresh = (cal_countdown == 0);
+  if (cal_fresh) {
+    readBurst24(CALIBRATION1, r, 2);
+    cal1Result = r[0];   // value of 1 cal cycle
+    cal2Result = r[1];   // value of CAL_PERIODS cycle
+  } else {
+    cal_countdown--;
+  }
+
+  // Apply any new adaptive timeout while the chip is idle (the shadow
+  // makes this free when the target hasn't changed)
+  write_ovf();
+
+  // Ack all interrupts
+  tdc_ack_int();
+  return true;
+}
+
+// Restart adaptive timeout learning from the configured ceiling
+void tdc7200Channel::reset_timeout() {
+  ovf_target = (uint16_t)config.TIMEOUT << 8;
+  clk_window_max = 0;
+  clk_window_n = 0;
+}
+
+// Program CLOCK_CNTR_OVF from ovf_target
+void tdc7200Channel::write_ovf() {
+  //clock counter overflow occurs when clock_countN > mask
+  write(CLOCK_CNTR_OVF_H, (byte)(ovf_target >> 8));
+  write(CLOCK_CNTR_OVF_L, (byte)(ovf_target & 0xFF));
+}
+
+// Adaptive timeout: track the largest CLOCK_COUNT1 seen over a window of
+// TIMEOUT_WINDOW events and set the overflow just above it (max + 1/8 +
+// TIMEOUT_MARGIN clocks), never above the configured TIMEOUT.  A missed
+// STOP then frees the chip sooner.  STOP is the next coarse tick, so no
+// valid measurement runs longer than one tick; the limit never drops
+// below that plus TIMEOUT_MARGIN, and a slow input is not cut off however
+// fast the window's events were.  An overflow still sends the limit
+// straight back to the ceiling (see fetch()).
+void tdc7200Channel::track_timeout() {
+  uint32_t ceiling = (uint32_t)config.TIMEOUT << 8;
+  uint32_t clk = (clock1Result < ceiling) ? clock1Result : ceiling;
+
+  if (clk > clk_window_max) clk_window_max = (uint16_t)clk;
+  if (++clk_window_n >= TIMEOUT_WINDOW) {
+    uint32_t ovf = (uint32_t)clk_window_max + (clk_window_max >> 3) + TIMEOUT_MARGIN;
+    uint32_t floor = (uint32_t)(PICTICK_PS / CLOCK_PERIOD) + TIMEOUT_MARGIN;
+    if (ovf < floor) ovf = floor;
+    ovf_target = (uint16_t)((ovf < ceiling) ? ovf : ceiling);
+    clk_window_max = 0;
+    clk_window_n = 0;
+  }
+}
+
+// Clear the calibration cache so the next event reads and seeds it
+void tdc7200Channel::reset_cal() {
+  cal_diff = 0;
+  cal_fresh = 0;
+  cal_countdown = 0;
+  cal_iir = 0;
+  cal_hist_n = 0;
+  cal_hist_pos = 0;
+  raw_cal_sent = 0;
+}
+
+// Feed freshly read CALIBRATION1/2 into the cache and filter.
+// 'N' holds the last raw value, 'I' is a single-pole IIR with weight
+// 1/2^CAL_IIR_SHIFT, 'M' is the median of the last CAL_MEDIAN_LEN reads.
+// If the raw value moves more than CAL_DRIFT counts from the filter
+// output, the filter is re-seeded and calibration is read again on the
+// next event rather than waiting out CAL_REFRESH.
+void tdc7200Channel::update_cal() {
+  uint32_t raw = cal2Result - cal1Result;
+  uint8_t seed = (cal_diff == 0);
+  uint8_t i, j;
+
+  if (!seed && (config.CAL_DRIFT > 0)) {
+    uint32_t dev = (raw > cal_diff) ? (raw - cal_diff) : (cal_diff - raw);
+    if (dev > (uint32_t)config.CAL_DRIFT) seed = 1;
+  }
+
+  cal_countdown = (config.CAL_REFRESH > 1) ? (uint16_t)(config.CAL_REFRESH - 1) : 0;
+
+  if (seed) {
+    cal_iir = (int32_t)raw << CAL_IIR_FRAC;
+    cal_hist[0] = raw;
+    cal_hist_n = 1;
+    cal_hist_pos = 1;
+    if (cal_diff != 0) cal_countdown = 0;  // drift: keep tracking until it settles
+    cal_diff = raw;
+    return;
+  }
+
+  switch (config.CAL_FILTER) {
+    case 'I':
+      cal_iir += (((int32_t)raw << CAL_IIR_FRAC) - cal_iir) >> CAL_IIR_SHIFT;
+      cal_diff = (uint32_t)((cal_iir + (1L << (CAL_IIR_FRAC - 1))) >> CAL_IIR_FRAC);
+      break;
+
+    case 'M':
+      {
+        uint32_t sorted[CAL_MEDIAN_LEN];
+        cal_hist[cal_hist_pos] = raw;
+        cal_hist_pos = (cal_hist_pos + 1) % CAL_MEDIAN_LEN;
+        if (cal_hist_n < CAL_MEDIAN_LEN) cal_hist_n++;
+        // insertion sort of at most CAL_MEDIAN_LEN entries
+        for (i = 0; i < cal_hist_n; ++i) {
+          uint32_t v = cal_hist[i];
+          for (j = i; (j > 0) && (sorted[j - 1] > v); --j) sorted[j] = sorted[j - 1];
+          sorted[j] = v;
+        }
+        cal_diff = sorted[cal_hist_n / 2];
+      }
+      break;
+
+    default:  // 'N' -- sample and hold
+      cal_diff = raw;
+      break;
+  }
+}
+
+// Recompute the fixed-point ring-oscillator LSB for a new calibration.
+// This is the only place the per-event math divides; compute_tof() just
+// multiplies by lsb_q24 and shifts.
+void tdc7200Channel::update_lsb(uint32_t cal_diff) {
   int64_t calCount;
-  int64_t ring_ticks;
-  int64_t ring_ps;
-  int64_t tof; 
+  int64_t normLSB;
+
+  lsb_cal_diff = cal_diff;
+
+  // calCount *= 10e6; divide back later
+  // time_dilation adjusts for non-linearity at 100ns overflow
+  calCount = ((int64_t)cal_diff * (int64_t)(1000000 - time_dilation) ) / (int64_t)(CAL_PERIODS - 1); 
+  if (calCount <= 0) {  // bogus calibration (e.g. after a timeout)
+    lsb_q24 = 0;
+    return;
+  }
+
+  // normLSB *= 10e6, but we've already multiplied the divisor
+  // above so we need to do 10e12 here
+  normLSB = ( (int64_t)CLOCK_PERIOD * (int64_t)1000000000000 ) / (int64_t)calCount;
+
+  // Convert from 1e-6 ps units to Q24 ps, rounded.  The ring LSB is
+  // ~55 ps, so this fits easily in 32 bits (limit is 256 ps).
+  lsb_q24 = (uint32_t)(((normLSB << LSB_FRAC_BITS) + 500000) / 1000000);
+}
+
+// Store the low n bytes of v little-endian at p
+static byte *put_le(byte *p, uint64_t v, uint8_t n) {
+  while (n--) {
+    *p++ = (byte)v;
+    v >>= 8;
+  }
+  return p;
+}
+
+// Raw mode: pack the registers captured by fetch() into buf (layout at
+// RAW_SYNC in tdc7200.h) and return the length.  The host does the
+// conversion, so this replaces compute_tof() and keeps its calibration
+// refresh bookkeeping; calibration is sent only when it differs from
+// what the host last saw.
+uint8_t tdc7200Channel::raw_record(byte *buf, uint8_t index) {
+  byte *p = buf;
+
+  byte flags = index;
+  if (cal_fresh) {
+    cal_countdown = (config.CAL_REFRESH > 1) ? (uint16_t)(config.CAL_REFRESH - 1) : 0;
+    if (!raw_cal_sent || (cal1Result != raw_cal1) || (cal2Result != raw_cal2)) {
+      raw_cal1 = cal1Result;
+      raw_cal2 = cal2Result;
+      raw_cal_sent = 1;
+      flags |= RAW_FLAG_CAL;
+    }
+  }
+
+  *p++ = RAW_SYNC;
+  *p++ = flags;
+  p = put_le(p, (uint64_t)PICstop_latched, 6);
+  p = put_le(p, time1Result, 3);
+  p = put_le(p, time2Result, 3);
+  p = put_le(p, clock1Result, 3);
+  if (flags & RAW_FLAG_CAL) {
+    p = put_le(p, raw_cal1, 3);
+    p = put_le(p, raw_cal2, 3);
+  }
+  return (uint8_t)(p - buf);
+}
+
+// Raw mode: record for a measurement that ended in a counter overflow
+uint8_t tdc7200Channel::raw_timeout(byte *buf, uint8_t index) {
+  buf[0] = RAW_SYNC;
+  buf[1] = index | RAW_FLAG_TIMEOUT;
+  put_le(buf + 2, (uint64_t)PICstop_latched, 6);
+  return RAW_TIMEOUT_LEN;
+}
+
+// Compute time of flight from the registers captured by fetch()
+int64_t tdc7200Channel::compute_tof() {
 
   //*****************************************************************
   // Datasheet says:
@@ -191,31 +496,59 @@ int64_t tdc7200Channel::read() {
   // It can never be larger because the STOP signal comes from the
   // 100us timer and the next edge will terminate the measurement.
   //
-  // These steps truncate ringps at 1ps resolution. Since normLSB is 
-  // multiplied by up to a few thousand ringticks, the truncation 
-  // error is multiplied as well.  So use mult/div to improve resolution.
+  // normLSB is only recomputed (in update_lsb()) when cal2 - cal1
+  // changes, and is kept as a Q24 fixed-point value in picoseconds,
+  // so the per-event path has no 64-bit divisions (see ring_time()).
+  //
+  // Error bound vs. the former per-event integer math
+  //   ring_ps = (normLSB * ring_ticks) / 1e6   (normLSB in 1e-6 ps):
+  // lsb_q24 is within 0.5 / 2^24 ps of normLSB / 1e6, so for
+  // |ring_ticks| < 2^15 the product differs by < 0.001 ps before
+  // truncation.  Both paths truncate toward zero, so the results are
+  // identical except when the exact product lies within 0.001 ps of an
+  // integer, where they can differ by exactly 1 ps (about 3 events in
+  // 100,000 over the realistic cal/time range).
  
   // For reference, by default:
   // CLOCK_PERIOD is 1e5 picosecond
-  // FUDGE is 0 
   // FIX_TIME2 is 0
   // CAL_PERIODS is 20
   // time_dilation is 2500 (adjusts for non-linearity)
   //*****************************************************************
   
-  // these variables are all int32_t members of the tdc7200Channel class
-  time1Result = readReg24(TIME1);         // START to next 100ns tick
-  time2Result  = readReg24(TIME2);        // 100ns tick to STOP
-  clock1Result = readReg24(CLOCK_COUNT1); // number of 100ns ticks
-  cal1Result = readReg24(CALIBRATION1);   // value of 1 cal cycle
-  cal2Result = readReg24(CALIBRATION2);   // value of CAL_PERIODS cycle
-  
-  tof = (int64_t)(clock1Result * CLOCK_PERIOD);
-  tof -= (int64_t)fudge; // subtract delay due to silicon and prop delay
-  
-  // calCount *= 10e6; divide back later
-  // time_dilation adjusts for non-linearity at 100ns overflow
-  calCount = ((int64_t)(cal2Result - cal1Result) * (int64_t)(1000000 - time_dilation) ) / (int64_t)(CAL_PERIODS - 1); 
+  if (default_timebase) {
+    tof = DefaultTimebase::clock_ps(clock1Result);
+  } else {
+    tof = ConfigTimebase::clock_ps(clock1Result);
+  }
+  tof += (int64_t)ring_time();
+  tof_is_split = 0;
+
+  return (int64_t)tof;
+}
+
+// floor(mag * q24 / 2^24) from 32-bit partial products (exact for
+// mag < 2^20; the fraction is taken 12 bits at a time)
+static uint32_t mul_q24(uint32_t mag, uint32_t q24) {
+  uint32_t frac = q24 & 0xFFFFFFUL;
+  uint32_t low = (mag * (frac & 0xFFF)) >> 12;
+  return mag * (q24 >> 24) + ((mag * (frac >> 12) + low) >> 12);
+}
+
+// Ring-oscillator part of tof in ps.  Also does the per-event
+// bookkeeping compute_tof() has always done: calibration filter and LSB
+// refresh, FIXED_TIME2 substitution.
+int32_t tdc7200Channel::ring_time() {
+  int32_t ring_ticks;
+  uint32_t ring_mag;
+  int32_t ring_ps;
+
+  if (cal_fresh) {
+    update_cal();
+  }
+  if (cal_diff != lsb_cal_diff) {
+    update_lsb(cal_diff);
+  }
 
   // if FIXED_TIME2 is set, substitute measured time2Result (which should be a fixed value,
   // with any variation being noise, with the provided value.  This reduces jitter.
@@ -223,21 +556,103 @@ int64_t tdc7200Channel::read() {
     time2Result = (int64_t)fixed_time2;
   }
   
-  // normLSB *= 10e6, but we've already multiplied the divisor
-  // above so we need to do 10e12 here
-  normLSB = ( (int64_t)CLOCK_PERIOD * (int64_t)1000000000000 ) / (int64_t)calCount;
-
-  ring_ticks = (int64_t)time1Result - (int64_t)time2Result;
+  ring_ticks = (int32_t)time1Result - (int32_t)time2Result;
  
-  // ring_ps *= 10e-6 to get rid of earlier scaling
-  ring_ps = ((int64_t)normLSB * (int64_t)ring_ticks) / (int64_t)1000000;
-  
-  tof += (int64_t)ring_ps;
+  // ring_ps = ring_ticks * LSB; fixed-point multiply and shift, done on
+  // the magnitude so it truncates toward zero like the old divide
+  ring_mag = (ring_ticks < 0) ? (uint32_t)(-ring_ticks) : (uint32_t)ring_ticks;
+  if (ring_mag < (1UL << 20)) {
+    ring_ps = (int32_t)mul_q24(ring_mag, lsb_q24);
+  } else {
+    ring_ps = (int32_t)(((uint64_t)ring_mag * lsb_q24) >> LSB_FRAC_BITS);
+  }
+  if (ring_ticks < 0) ring_ps = -ring_ps;
+  return ring_ps;
+}
 
-  // Ack all interrupts
-  tdc_ack_int();
+// Coarse clock count in split form: whole microseconds and the ps
+// remainder.  False if the clock period doesn't divide 1 us.
+template <class TB>
+static bool clock_split(uint32_t clocks, int32_t *hi, int32_t *lo) {
+  uint32_t per_us = TB::clocks_per_us();
+  if (!per_us) return false;
+  *hi = (int32_t)(clocks / per_us);
+  *lo = (int32_t)((clocks % per_us) * (1000000UL / per_us));
+  return true;
+}
 
-  return (int64_t)tof;
+// Same tof as compute_tof(), built directly in the split form used by
+// timestamp assembly (tof_hi whole microseconds, tof_lo ps 0..999999)
+// with 32-bit arithmetic only.  If the clock period doesn't fit that
+// form, tof is computed the 64-bit way instead and false returned;
+// tof_ps() gives the value either way.
+bool tdc7200Channel::compute_tof_split() {
+  int32_t ring_ps = ring_time();
+  int32_t hi, lo;
+  bool ok;
+
+  if (default_timebase) {
+    ok = clock_split<DefaultTimebase>(clock1Result, &hi, &lo);
+  } else {
+    ok = clock_split<ConfigTimebase>(clock1Result, &hi, &lo);
+  }
+  if (!ok || (ring_ps <= -1000000L) || (ring_ps >= 1000000L)) {
+    tof = ConfigTimebase::clock_ps(clock1Result) + (int64_t)ring_ps;
+    tof_is_split = 0;
+    return false;
+  }
+
+  lo += ring_ps;  // within (-1e6, 2e6)
+  if (lo < 0) {
+    lo += 1000000L;
+    hi--;
+  } else if (lo >= 1000000L) {
+    lo -= 1000000L;
+    hi++;
+  }
+  tof_hi = hi;
+  tof_lo = (uint32_t)lo;
+  tof_is_split = 1;
+  return true;
+}
+
+// tof in ps, whichever way it was last computed
+int64_t tdc7200Channel::tof_ps() const {
+  if (tof_is_split) return (int64_t)tof_hi * 1000000LL + tof_lo;
+  return tof;
+}
+
+// Split v into floor(v / 1e6) and the 0..999999 remainder; false if
+// |v| >= 1e12, outside what the per-event split math allows for
+static bool split_ps(int64_t v, int32_t *hi, uint32_t *lo) {
+  if ((v <= -PS_PER_SEC) || (v >= PS_PER_SEC)) return false;
+  int64_t h = v / 1000000LL;
+  int64_t l = v % 1000000LL;
+  if (l < 0) {
+    l += 1000000LL;
+    h--;
+  }
+  *hi = (int32_t)h;
+  *lo = (uint32_t)l;
+  return true;
+}
+
+// Fold the channel's constant corrections into the single offset
+// stamp_channel() subtracts from each timestamp.  This keeps the net
+// correction the firmware has always applied: tof lost PROP_DELAY +
+// FUDGE0 and the timestamp then lost tof and PROP_DELAY again, so
+// PROP_DELAY cancels and FUDGE0 is added back.  Called whenever the
+// config changes, never per event.
+void tdc7200Channel::set_offset(int64_t prop_delay, int64_t fudge0) {
+  offset = prop_delay - (prop_delay + fudge0);
+  offset_is_split = split_ps(offset, &offset_hi, &offset_lo);
+}
+
+// Read TDC (fetch and compute in one step, no early re-arm).
+// A timed-out measurement yields the previous tof.
+int64_t tdc7200Channel::read() {
+  if (!fetch()) return tof;
+  return compute_tof();
 }
 
 
@@ -250,6 +665,9 @@ SPI read/write
 // data is clocked on the rising edge of the clock (seems to be SPI_MODE0)
 // max clock speed: 20 mHz
 
+// Every transaction bumps spi_xfers so the per-event SPI cost (fetch
+// plus re-arm) can be shown in Debug mode.
+
 byte tdc7200Channel::readReg8(byte address) {
   byte inByte = 0;
 
@@ -262,6 +680,7 @@ byte tdc7200Channel::readReg8(byte address) {
 
   digitalWrite(CSB, HIGH);
   SPI.endTransaction();
+  spi_xfers++;
 
   return inByte;
 }
@@ -269,7 +688,8 @@ byte tdc7200Channel::readReg8(byte address) {
 uint32_t tdc7200Channel::readReg24(byte address) {
   uint32_t value = 0;
 
-  // CSB needs to be toggled between 24-bit register reads
+  // CSB needs to be toggled between single 24-bit register reads
+  // (see readBurst24() for reading adjacent registers in one go)
   SPI.beginTransaction(SPISettings(SPI_SPEED, MSBFIRST, SPI_MODE0));
   digitalWrite(CSB, LOW);
 
@@ -283,27 +703,71 @@ uint32_t tdc7200Channel::readReg24(byte address) {
 
   digitalWrite(CSB, HIGH);
   SPI.endTransaction();
+  spi_xfers++;
   delayMicroseconds(5);
   return value;
 }
 
+// Read 'count' consecutive 24-bit registers in a single transaction.
+// With the auto-increment bit set the chip steps the address itself,
+// so CSB only has to be toggled once for the whole block.
+void tdc7200Channel::readBurst24(byte address, uint32_t *values, uint8_t count) {
+  SPI.beginTransaction(SPISettings(SPI_SPEED, MSBFIRST, SPI_MODE0));
+  digitalWrite(CSB, LOW);
+
+  SPI.transfer((address & 0x1f) | SPI_AUTOINC_BIT);
+
+  for (uint8_t i = 0; i < count; ++i) {
+    uint16_t msb = SPI.transfer(0x00);
+    uint16_t mid = SPI.transfer(0x00);
+    uint16_t lsb = SPI.transfer(0x00);
+    values[i] = ((uint32_t)msb << 16) + (mid << 8) + lsb;
+  }
+
+  digitalWrite(CSB, HIGH);
+  SPI.endTransaction();
+  spi_xfers++;
+  delayMicroseconds(5);
+}
+
+// Write a register, skipping the transaction if the shadow says the chip
+// already holds that value.  A CONFIG1 write with START_MEAS set is a
+// command rather than state, so it always goes out.
 void tdc7200Channel::write(byte address, byte value) {
+  uint8_t shadowed = (address < TDC_NUM_CONFIG_REG) && (address != INT_STATUS);
+
+  if (shadowed && (shadow_valid & (1 << address)) && (shadow[address] == value) &&
+      !((address == CONFIG1) && (value & START_MEAS_BIT))) {
+    return;
+  }
 
   // take the chip select low to select the device:
   SPI.beginTransaction(SPISettings(SPI_SPEED, MSBFIRST, SPI_MODE0));
   digitalWrite(CSB, LOW);
 
   // Force Address bit 6 to one for a write
-  SPI.transfer16((address | 0x40) << 8 | value);
+  SPI.transfer16((address | SPI_WRITE_BIT) << 8 | value);
 
   digitalWrite(CSB, HIGH);
   SPI.endTransaction();
+  spi_xfers++;
+
+  if (shadowed) {
+    shadow[address] = value;
+    shadow_valid |= (1 << address);
+  }
+}
+
+// Forget all shadowed register values; the next write of each goes out
+void tdc7200Channel::invalidate_shadow() {
+  shadow_valid = 0;
 }
 
 // Stop TDC7200 measurements
 void tdc7200Channel::stop_measurements() {
   // Stop current measurement by clearing START_MEAS bit
-  byte stop_config = config_byte1 & ~0x01;  // Clear START_MEAS bit
+  // (skipped by the shadow if the chip is already stopped)
+  byte stop_config = config_byte1 & ~START_MEAS_BIT;  // Clear START_MEAS bit
   write(CONFIG1, stop_config);
 }
 
@@ -11,6 +11,45 @@
 
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
 #define SPI_SPEED         (int32_t)  20000000 // 20MHz maximum
+#define SPI_WRITE_BIT     0x40                // command byte: write access
+#define SPI_AUTOINC_BIT   0x80                // command byte: auto-increment address
+#define START_MEAS_BIT    0x01                // CONFIG1 start strobe, self-clears at completion
+#define INT_STATUS_ALL    0x1F                // write-1-to-clear mask for every INT_STATUS flag
+#define TDC_NUM_CONFIG_REG 10                 // CONFIG1 (0x00) .. CLOCK_CNTR_STOP_MASK_L (0x09)
+#define FLUSH_TIMEOUT_US  10000               // safety cap on waiting for an idle chip
+#define TDC_ENABLE_LOW_MS 5                   // ENABLE low time before power-up
+#define TDC_LDO_SETTLE_MS 5                   // LDO settle after ENABLE rises (1.5 ms min)
+#define TDC_ALIGN_TIMEOUT_US 1000             // give up COARSE phase alignment after this
+#define TIMEOUT_WINDOW    256                 // events per adaptive-timeout window
+#define TIMEOUT_MARGIN    16                  // extra clocks above the observed maximum
+
+// INT_STATUS bits
+const byte NEW_MEAS_INT =       0x01;
+const byte COARSE_CNTR_OVF_INT = 0x02;
+const byte CLOCK_CNTR_OVF_INT = 0x04;
+const byte MEAS_STARTED_FLAG =  0x08;
+const byte MEAS_COMPLETE_FLAG = 0x10;
+
+enum FlushState : uint8_t {FLUSH_IDLE, FLUSH_WAIT};
+#define LSB_FRAC_BITS     24                  // fraction bits of lsb_q24
+#define CAL_IIR_FRAC      8                   // fraction bits of the cal IIR accumulator
+#define CAL_IIR_SHIFT     3                   // IIR weight of a new cal sample is 1/2^N
+#define CAL_MEDIAN_LEN    5                   // cal samples held for the median filter
+
+// Raw mode binary record, all fields little-endian:
+//   [0]      RAW_SYNC
+//   [1]      flags: channel index in bits 0-3, RAW_FLAG_CAL, RAW_FLAG_TIMEOUT
+//   [2..7]   PICstop, low 48 bits (100 us ticks)
+// then, unless RAW_FLAG_TIMEOUT:
+//   [8..10]  TIME1   [11..13] TIME2   [14..16] CLOCK_COUNT1
+// then, if RAW_FLAG_CAL (calibration changed since the last record):
+//   [17..19] CALIBRATION1   [20..22] CALIBRATION2
+#define RAW_SYNC          0xA5
+#define RAW_FLAG_CAL      0x80
+#define RAW_FLAG_TIMEOUT  0x40
+#define RAW_TIMEOUT_LEN   8
+#define RAW_EVENT_LEN     17
+#define RAW_RECORD_MAX    23
 
 // TDC7200 register addresses
 const int CONFIG1 =        0x00;           // default 0x00
@@ -52,6 +91,7 @@ public:
 
   // NOTE: changed all from signed to unsigned while working on TINT
   volatile int64_t PICstop;
+  int64_t PICstop_latched;  // PICstop as captured by fetch(), stable after re-arm
   uint32_t time1Result;
   uint32_t time2Result;
   uint32_t time3Result;
@@ -59,17 +99,49 @@ public:
   uint32_t cal1Result;
   uint32_t cal2Result;
   
-  int64_t tof;
+  int64_t tof;              // valid when !tof_is_split; use tof_ps() to read
   int64_t last_tof;
-  int64_t totalize;
+  int32_t  tof_hi;          // tof from compute_tof_split(): floor(ps / 1e6)
+  uint32_t tof_lo;          // and the ps remainder, 0..999999
+  uint8_t  tof_is_split;    // tof_hi/tof_lo hold the current tof
+  int64_t totalize;         // completed events
   // removed ts_frac_ps; represented via SplitTime chunks
   volatile uint8_t new_ts_ready; // set when a fresh ts_* is available for pairing
   SplitTime ts_split;       // unified split timestamp (sec, frac_hi, frac_lo)
   SplitTime last_ts_split;  // previous split timestamp
-  int64_t prop_delay;
   int64_t time_dilation;
   int64_t fixed_time2;
-  int64_t fudge;
+  // All constant per-channel corrections in one place: ps subtracted
+  // from every timestamp, net -FUDGE0 as before (see set_offset()),
+  // also held split like tof_hi/tof_lo
+  int64_t  offset;
+  int32_t  offset_hi;
+  uint32_t offset_lo;
+  uint8_t  offset_is_split; // offset fits the split form
+
+  // Calibration cache: CALIBRATION1/2 are only read every config.CAL_REFRESH
+  // events and cal2 - cal1 is filtered per config.CAL_FILTER
+  uint32_t cal_diff;        // filtered cal2Result - cal1Result used by compute_tof()
+  uint8_t  cal_fresh;       // set by fetch() when new cal registers were read
+  uint16_t cal_countdown;   // events left before calibration is read again
+  int32_t  cal_iir;         // IIR accumulator, cal counts << CAL_IIR_FRAC
+  uint32_t cal_hist[CAL_MEDIAN_LEN];  // recent raw cal diffs for the median filter
+  uint8_t  cal_hist_n;      // number of valid entries in cal_hist
+  uint8_t  cal_hist_pos;    // next slot to overwrite in cal_hist
+  uint8_t  raw_cal_sent;    // raw mode: raw_cal1/raw_cal2 have been sent
+  uint32_t raw_cal1;        // raw mode: last CALIBRATION1 sent to the host
+  uint32_t raw_cal2;        // raw mode: last CALIBRATION2 sent to the host
+
+  // Measurement timeout (CLOCK_CNTR_OVF); adaptive when config.TIMEOUT_MODE is 'A'
+  uint8_t  int_status;      // INT_STATUS read by the last fetch()
+  uint16_t ovf_target;      // CLOCK_CNTR_OVF value programmed at the next fetch()
+  uint16_t clk_window_max;  // largest clock1Result in the current window
+  uint16_t clk_window_n;    // events seen in the current window
+  uint32_t timeouts;        // measurements ended by a counter overflow
+
+  // Ring-oscillator LSB in Q24 picoseconds, cached per calibration result
+  uint32_t lsb_cal_diff;  // cal2Result - cal1Result that lsb_q24 was built from
+  uint32_t lsb_q24;
 
   // Incremental coarse-time decomposition cache (optional optimization)
   int64_t  last_picstop;
@@ -77,24 +149,98 @@ public:
   int32_t  cached_rem_ticks;
 
   char      name; // channel name
+  char      start_edge;  // config.START_EDGE for this channel, used by tdc_configure()
 
   byte    config_byte1;
   byte    config_byte2;
+
+  // Polled flush state (see begin_flush()/poll_flush())
+  FlushState flush_state;
+  uint32_t   flush_start_us;
+
+  // Shadow of the configuration registers so writes of unchanged values
+  // can be skipped.  INT_STATUS is write-1-to-clear and is never skipped.
+  byte     shadow[TDC_NUM_CONFIG_REG];
+  uint16_t shadow_valid;  // bit N set when shadow[N] matches the chip
+  uint8_t  spi_xfers;     // SPI transactions since the last fetch()
   
   tdc7200Channel(char id, int enable, int intb, int csb, int stop, int led);
-  int64_t read();
-  void tdc_setup();
+  bool fetch();            // SPI only: latch PICstop, read result registers, ack INTB
+  int64_t compute_tof();   // ring-oscillator math on the fetched registers
+  bool compute_tof_split();  // same, into tof_hi/tof_lo with 32-bit math
+  int64_t tof_ps() const;  // current tof in ps from either form
+  // Event number for sequence tags, binary records and the frequency
+  // fit: completed events plus timeouts, so a timeout leaves a gap
+  int64_t seq() const { return totalize + timeouts; }
+  void set_offset(int64_t prop_delay, int64_t fudge0);  // build offset from config
+  int64_t read();          // fetch() + compute_tof()
+  uint8_t raw_record(byte *buf, uint8_t index);   // raw mode: pack fetched registers
+  uint8_t raw_timeout(byte *buf, uint8_t index);  // raw mode: counter overflow marker
+  void tdc_setup();        // power-cycle, align and configure this chip alone
+  void tdc_power(bool on); // drive ENABLE
+  void tdc_configure();    // program registers; chip must be enabled
   void ready_next();
   void flush_and_reset();  // Clear partial measurements and reset state
+  void begin_flush();      // Start a non-blocking flush
+  bool poll_flush();       // Advance the flush; true when done
   void reset_channel_state();  // Reset channel variables without hardware reset
+  void reset_cal();  // Drop cached calibration; next event re-reads it
   void stop_measurements();  // Stop TDC7200 measurements
   void start_measurements();  // Start TDC7200 measurements
   byte readReg8(byte address);
   uint32_t readReg24(byte address);
+  void readBurst24(byte address, uint32_t *values, uint8_t count);
   void write(byte address, byte value);
+  void invalidate_shadow();  // Forget shadowed registers (e.g. after chip reset)
 
 private:
   void tdc_ack_int();
+  int32_t ring_time();
+  void update_lsb(uint32_t cal_diff);
+  void update_cal();
+  void reset_timeout();
+  void write_ovf();
+  void track_timeout();
+};
+
+// Timebase traits for the per-event math.  DefaultTimebase is the stock
+// 10 MHz clock / 100 us coarse tick as compile-time constants, so the
+// multiplies fold; ConfigTimebase reads the runtime globals for any other
+// clock.  default_timebase (set from the live config) picks between them.
+// clocks_per_us() is reference clocks per microsecond (0 if the period
+// doesn't divide 1 us), for building tof in split form.
+// tick_us() is the coarse tick in whole microseconds (0 if it isn't one):
+// the remainder then maps straight to frac_hi as rem * tick_us with
+// frac_lo = 0, so no lookup table or 64-bit split is needed.
+extern int64_t CLOCK_PERIOD;
+extern int64_t PICTICK_PS;
+extern int64_t ticksPerSecond;
+extern int32_t pictick_us;
+extern uint32_t clock_per_us;
+extern bool default_timebase;
+
+struct DefaultTimebase {
+  static constexpr int64_t PERIOD_PS = PS_PER_SEC / DEFAULT_CLOCK_HZ;
+  static constexpr int64_t TICK_PS = DEFAULT_PICTICK_PS;
+  static constexpr int32_t tick_us() { return (TICK_PS % 1000000 == 0) ? (int32_t)(TICK_PS / 1000000) : 0; }
+  static int64_t clock_ps(uint32_t clocks) {
+    if (clocks <= (uint32_t)(UINT32_MAX / PERIOD_PS)) return (uint32_t)(clocks * (uint32_t)PERIOD_PS);
+    return (int64_t)clocks * PERIOD_PS;
+  }
+  static int64_t tick_ps(int32_t ticks) { return (int64_t)ticks * TICK_PS; }
+  static constexpr uint32_t clocks_per_us() { return (1000000 % PERIOD_PS == 0) ? (uint32_t)(1000000 / PERIOD_PS) : 0; }
+  static int32_t ticks_per_sec() { return (int32_t)(PS_PER_SEC / TICK_PS); }
 };
 
+struct ConfigTimebase {
+  static int32_t tick_us() { return pictick_us; }
+  static int64_t clock_ps(uint32_t clocks) { return (int64_t)clocks * CLOCK_PERIOD; }
+  static int64_t tick_ps(int32_t ticks) { return (int64_t)ticks * PICTICK_PS; }
+  static uint32_t clocks_per_us() { return clock_per_us; }
+  static int32_t ticks_per_sec() { return (int32_t)ticksPerSecond; }
+};
+
+// Power up and configure several chips in parallel
+void tdc_setup_all(tdc7200Channel *chans, size_t n);
+
 #endif /* TDC7200_H */
@@ -0,0 +1,217 @@
+// uart0.cpp -- interrupt-driven USART0 driver with a large TX ring
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+#include <stdint.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "uart0.h"
+
+#define TX_MASK  (UART0_TX_SIZE - 1)
+#define RX_MASK  (UART0_RX_SIZE - 1)
+static_assert((UART0_TX_SIZE & TX_MASK) == 0, "UART0_TX_SIZE must be a power of two");
+static_assert((UART0_RX_SIZE & RX_MASK) == 0 && UART0_RX_SIZE <= 256,
+              "UART0_RX_SIZE must be a power of two no larger than 256");
+
+Uart0 TiccSerial;
+
+// tx_head is only written by the main line and tx_tail only by the UDRE
+// interrupt, or by unqueue() while that interrupt is masked; either side
+// reads the other's index with interrupts off since the indices are 16
+// bits.  The RX indices are single bytes.
+static uint8_t tx_buf[UART0_TX_SIZE];
+static volatile uint16_t tx_head;
+static volatile uint16_t tx_tail;
+static uint8_t rx_buf[UART0_RX_SIZE];
+static volatile uint8_t rx_head;
+static volatile uint8_t rx_tail;
+
+// Send the next queued byte; UDRE0 must be set.  Writing TXC0 clears it
+// so flush() can tell when the shifter is done.
+static inline void tx_next() {
+  uint16_t t = tx_tail;
+  UDR0 = tx_buf[t];
+  UCSR0A = (UCSR0A & (_BV(U2X0) | _BV(MPCM0))) | _BV(TXC0);
+  t = (t + 1) & TX_MASK;
+  tx_tail = t;
+  if (t == tx_head) UCSR0B &= ~_BV(UDRIE0);
+}
+
+ISR(USART0_UDRE_vect) {
+  tx_next();
+}
+
+ISR(USART0_RX_vect) {
+  bool parity_error = (UCSR0A & _BV(UPE0));
+  uint8_t c = UDR0;
+  uint8_t next = (uint8_t)((rx_head + 1) & RX_MASK);
+  if (!parity_error && (next != rx_tail)) {  // drop on overrun, as the core does
+    rx_buf[rx_head] = c;
+    rx_head = next;
+  }
+}
+
+static uint16_t get_tail() {
+  uint16_t t;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { t = tx_tail; }
+  return t;
+}
+
+// While interrupts are off (called from an ISR, or with cli()) the ring
+// can't drain by itself, so move a byte by polling instead of hanging
+static void tx_poll() {
+  if (!(SREG & 0x80) && (UCSR0A & _BV(UDRE0))) {
+    if (get_tail() != tx_head) tx_next();
+  }
+}
+
+// UBRR for baud, with the actual rate in *actual.  Double speed (U2X)
+// is used unless the divider doesn't fit in 12 bits.
+static uint16_t ubrr_for(int32_t baud, bool *u2x, int32_t *actual) {
+  uint32_t ubrr = (F_CPU / 4 / (uint32_t)baud - 1) / 2;
+  *u2x = (ubrr <= 4095);
+  if (!*u2x) ubrr = (F_CPU / 8 / (uint32_t)baud - 1) / 2;
+  if (ubrr > 4095) ubrr = 4095;
+  *actual = (int32_t)(F_CPU / (*u2x ? 8UL : 16UL) / (ubrr + 1));
+  return (uint16_t)ubrr;
+}
+
+int32_t Uart0::begin(int32_t baud) {
+  bool u2x = true;
+  int32_t actual = 0;
+  uint16_t ubrr = 0;
+
+  if ((baud > 0) && (baud <= (int32_t)(F_CPU / 8))) {
+    ubrr = ubrr_for(baud, &u2x, &actual);
+  }
+  // More than 2.5% off (230400 at 16 MHz, for one) won't frame reliably
+  // against the USB bridge; fall back to a rate that does.  115200 is
+  // 2.1% off here, as it is on every 16 MHz Arduino.
+  if ((actual == 0) || (labs(actual - baud) > baud / 40)) {
+    baud = BOOT_BAUD;
+    ubrr = ubrr_for(baud, &u2x, &actual);
+  }
+
+  end();
+  UCSR0A = u2x ? _BV(U2X0) : 0;
+  UBRR0H = (uint8_t)(ubrr >> 8);
+  UBRR0L = (uint8_t)ubrr;
+  UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);  // 8N1
+  UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+  cur_baud = baud;
+  written = false;
+  return baud;
+}
+
+void Uart0::end() {
+  if (UCSR0B & _BV(TXEN0)) flush();
+  UCSR0B &= ~(_BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0) | _BV(UDRIE0));
+  rx_tail = rx_head;
+}
+
+int Uart0::available() {
+  return (int)((uint8_t)(rx_head - rx_tail) & RX_MASK);
+}
+
+int Uart0::peek() {
+  if (rx_head == rx_tail) return -1;
+  return rx_buf[rx_tail];
+}
+
+int Uart0::read() {
+  if (rx_head == rx_tail) return -1;
+  uint8_t c = rx_buf[rx_tail];
+  rx_tail = (uint8_t)((rx_tail + 1) & RX_MASK);
+  return c;
+}
+
+int Uart0::availableForWrite() {
+  return (int)((get_tail() - tx_head - 1) & TX_MASK);
+}
+
+uint16_t Uart0::queued() {
+  return (tx_head - get_tail()) & TX_MASK;
+}
+
+// Remove len bytes that sit just before the newest newer bytes in the
+// ring, provided none of them has gone out yet; the output queue uses it
+// to drop its oldest record.  Only the UDRE interrupt is masked, so the
+// coarse-tick and STOP interrupts are not held off by the copy.  Unsent
+// bytes older than the dropped run (at most the rest of a record) slide
+// up over it.
+bool Uart0::unqueue(uint16_t newer, uint16_t len) {
+  bool ok;
+  UCSR0B &= ~_BV(UDRIE0);         // hold tx_tail still; the shifter keeps going
+  uint16_t t = tx_tail;
+  uint16_t q = (tx_head - t) & TX_MASK;
+  ok = (len > 0) && (newer + len <= q);
+  if (ok) {
+    for (uint16_t i = q - newer - len; i-- > 0; ) {
+      tx_buf[(t + len + i) & TX_MASK] = tx_buf[(t + i) & TX_MASK];
+    }
+    tx_tail = (t + len) & TX_MASK;
+  }
+  if (tx_tail != tx_head) UCSR0B |= _BV(UDRIE0);
+  return ok;
+}
+
+void Uart0::flush() {
+  if (!written) return;
+  // the UDRE interrupt clears UDRIE0 when the ring empties
+  while ((UCSR0B & _BV(UDRIE0)) || !(UCSR0A & _BV(TXC0))) {
+    tx_poll();
+  }
+}
+
+size_t Uart0::write(uint8_t c) {
+  written = true;
+
+  // Ring empty and data register free: skip the ring, as the core does
+  if ((get_tail() == tx_head) && (UCSR0A & _BV(UDRE0))) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      UDR0 = c;
+      UCSR0A = (UCSR0A & (_BV(U2X0) | _BV(MPCM0))) | _BV(TXC0);
+    }
+    return 1;
+  }
+
+  uint16_t head = tx_head;
+  uint16_t next = (head + 1) & TX_MASK;
+  while (next == get_tail()) tx_poll();  // ring full: wait for room
+  tx_buf[head] = c;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    tx_head = next;
+    UCSR0B |= _BV(UDRIE0);
+  }
+  return 1;
+}
+
+// Copy whole runs into the ring and kick the interrupt once per run
+// rather than once per byte.  Blocks only while the ring is full.
+size_t Uart0::write(const uint8_t *buf, size_t n) {
+  size_t left = n;
+  written = true;
+
+  while (left) {
+    uint16_t head = tx_head;
+    uint16_t room = (get_tail() - head - 1) & TX_MASK;
+    if (room == 0) {
+      tx_poll();
+      continue;
+    }
+    if (room > UART0_TX_SIZE - head) room = UART0_TX_SIZE - head;  // up to the wrap
+    if (room > left) room = (uint16_t)left;
+    memcpy(tx_buf + head, buf, room);
+    buf += room;
+    left -= room;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      tx_head = (head + room) & TX_MASK;
+      UCSR0B |= _BV(UDRIE0);
+    }
+  }
+  return n;
+}
@@ -0,0 +1,55 @@
+#ifndef UART0_H
+#define UART0_H
+
+// uart0.h -- interrupt-driven USART0 driver with a large TX ring
+
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+// Replaces the core's HardwareSerial on USART0 (the USB bridge).  The
+// core's 64-byte TX buffer holds barely two timestamp lines, so output
+// blocked acquisition whenever the host fell behind by a few ms.  This
+// driver keeps the same Stream interface with a bigger ring, bulk
+// copies in write(buf, n), and baud rates up to 2 Mbaud.
+//
+// Serial is remapped to TiccSerial below, so the rest of the sketch is
+// unchanged.  The core's USART0 interrupt handlers are then never
+// linked, since nothing references its Serial object.
+
+#include <Arduino.h>
+
+#ifndef UART0_TX_SIZE
+#define UART0_TX_SIZE   512       // TX ring bytes; power of two
+#endif
+#ifndef UART0_RX_SIZE
+#define UART0_RX_SIZE   64        // RX ring bytes; power of two, <= 256
+#endif
+#define BOOT_BAUD       115200L   // rate for the banner and config prompt, and the fallback
+
+class Uart0 : public Stream {
+public:
+  int32_t begin(int32_t baud);    // returns the rate actually set
+  void end();
+  int32_t baud() const { return cur_baud; }
+  virtual int available();
+  virtual int peek();
+  virtual int read();
+  virtual int availableForWrite();
+  virtual void flush();           // wait until the last byte has left the shifter
+  virtual size_t write(uint8_t c);
+  virtual size_t write(const uint8_t *buf, size_t n);
+  using Print::write;
+  uint16_t queued();              // bytes in the TX ring not yet sent
+  bool unqueue(uint16_t newer, uint16_t len);  // drop len unsent bytes older than the newest newer
+  operator bool() { return true; }
+private:
+  int32_t cur_baud;
+  bool written;                   // a byte went out since begin()
+};
+
+extern Uart0 TiccSerial;
+#define Serial TiccSerial
+
+#endif  /* UART0_H */
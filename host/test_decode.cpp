@@ -0,0 +1,168 @@
+// test_decode.cpp -- check the host decoder against the board's own output
+//
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+//
+// Usage: test_decode [debug_capture]
+//   (default ../docs/ticc_rev_d_loopback_chA_debug.txt)
+// Each Debug line carries the raw TDC7200 registers together with the
+// timestamp the firmware computed from them.  Every event is decoded
+// twice, straight from its Debug line and re-encoded as a Raw record,
+// and both results must match the board's timestamp to 12 places.  The
+// Raw stream opens with an event ahead of its channel's calibration and
+// a timeout record; the first must be dropped as uncalibrated and the
+// second counted.  Exits 0 when everything matches.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "ticc_raw.h"
+
+#define PLACES 12
+
+static void put_le(std::vector<uint8_t> &v, uint64_t x, int n) {
+  while (n--) { v.push_back((uint8_t)x); x >>= 8; }
+}
+
+// One Raw record as tdc7200Channel::raw_record() writes it
+static void put_raw(std::vector<uint8_t> &v, uint8_t ch, uint64_t pic, uint32_t t1, uint32_t t2,
+                    uint32_t c1, bool cal, uint32_t cal1, uint32_t cal2) {
+  v.push_back(TICC_RAW_SYNC);
+  v.push_back((uint8_t)(ch | (cal ? TICC_RAW_FLAG_CAL : 0)));
+  put_le(v, pic, 6);
+  put_le(v, t1, 3); put_le(v, t2, 3); put_le(v, c1, 3);
+  if (cal) { put_le(v, cal1, 3); put_le(v, cal2, 3); }
+}
+
+// The token just before the chX tag: the firmware's timestamp
+static bool board_timestamp(const char *line, char *ts, size_t cap) {
+  const char *prev = NULL, *p = line;
+  size_t prev_len = 0;
+  while (*p) {
+    while (*p == ' ' || *p == '\t') p++;
+    if (!*p || *p == '\r' || *p == '\n') break;
+    const char *tok = p;
+    while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+    if (tok[0] == 'c' && tok[1] == 'h') {
+      if (!prev || prev_len >= cap) return false;
+      memcpy(ts, prev, prev_len);
+      ts[prev_len] = '\0';
+      return true;
+    }
+    prev = tok;
+    prev_len = (size_t)(p - tok);
+  }
+  return false;
+}
+
+static size_t check(const char *what, const std::vector<TiccSplitTime> &got,
+                    const std::vector<std::vector<char> > &want) {
+  size_t bad = 0;
+  char line[64];
+  if (got.size() != want.size()) {
+    printf("%s: %zu events decoded, %zu expected\n", what, got.size(), want.size());
+    return 1;
+  }
+  for (size_t i = 0; i < got.size(); ++i) {
+    size_t n = ticc_format_timestamp(line, sizeof(line) - 1, got[i], PLACES, 0);
+    line[n] = '\0';
+    if (strcmp(line, want[i].data()) != 0) {
+      if (bad++ < 5) printf("%s: event %zu decoded %s, board %s\n", what, i, line, want[i].data());
+    }
+  }
+  return bad;
+}
+
+int main(int argc, char **argv) {
+  const char *path = (argc > 1) ? argv[1] : "../docs/ticc_rev_d_loopback_chA_debug.txt";
+  FILE *in = fopen(path, "r");
+  if (!in) { perror(path); return 1; }
+
+  TiccTimebase tb;
+  TiccChannelParams params[TICC_MAX_CHANNELS];
+  for (int i = 0; i < TICC_MAX_CHANNELS; ++i) params[i].name = (char)('A' + i);
+
+  TiccBatch debug;
+  std::vector<std::vector<char> > want;
+  char line[256], ts[40];
+  while (fgets(line, sizeof(line), in)) {
+    if (!ticc_parse_debug_line(line, params, TICC_MAX_CHANNELS, debug)) continue;
+    if (!board_timestamp(line, ts, sizeof(ts))) ts[0] = '\0';   // can't match
+    want.push_back(std::vector<char>(ts, ts + strlen(ts) + 1));
+  }
+  fclose(in);
+  if (want.empty()) {
+    printf("%s: no usable Debug lines\n", path);
+    return 1;
+  }
+
+  // The same events as a Raw stream, calibration only when it changes
+  std::vector<uint8_t> raw;
+  const char banner[] = "# raw binary records follow\r\n";
+  raw.insert(raw.end(), banner, banner + sizeof(banner) - 1);
+  put_raw(raw, debug.chan[0], (uint64_t)debug.picstop[0], 1, 1, 1, false, 0, 0);
+  raw.push_back(TICC_RAW_SYNC);
+  raw.push_back((uint8_t)(debug.chan[0] | TICC_RAW_FLAG_TIMEOUT));
+  put_le(raw, (uint64_t)debug.picstop[0], 6);
+  uint32_t last_cal[TICC_MAX_CHANNELS];
+  bool sent[TICC_MAX_CHANNELS] = {false};
+  for (size_t i = 0; i < debug.size(); ++i) {
+    uint8_t ch = debug.chan[i];
+    bool cal = !sent[ch] || debug.cal_diff[i] != last_cal[ch];
+    sent[ch] = true;
+    last_cal[ch] = debug.cal_diff[i];
+    // only the difference is decoded, so any cal1 will do
+    put_raw(raw, ch, (uint64_t)debug.picstop[i], debug.time1[i], debug.time2[i],
+            debug.clock1[i], cal, 1000, 1000 + debug.cal_diff[i]);
+  }
+
+  // Feed it in odd-sized pieces to exercise partial records
+  TiccRawParser parser;
+  TiccBatch fromraw;
+  size_t have = 0, pos = 0;
+  std::vector<uint8_t> buf(64);
+  while (pos < raw.size() || have) {
+    size_t take = raw.size() - pos;
+    if (take > 37) take = 37;
+    if (take > buf.size() - have) take = buf.size() - have;
+    memcpy(buf.data() + have, raw.data() + pos, take);
+    pos += take;
+    have += take;
+    size_t used = parser.feed(buf.data(), have, fromraw);
+    memmove(buf.data(), buf.data() + used, have - used);
+    have -= used;
+    if (!take && !used) break;
+  }
+
+  size_t bad = 0;
+  uint8_t ch0 = debug.chan[0];
+  if (have) { printf("raw: %zu bytes left unparsed\n", have); bad++; }
+  if (parser.uncal[ch0] != 1) {
+    printf("raw: %llu uncalibrated events, 1 expected\n", (unsigned long long)parser.uncal[ch0]);
+    bad++;
+  }
+  if (parser.timeouts[ch0] != 1) {
+    printf("raw: %llu timeouts, 1 expected\n", (unsigned long long)parser.timeouts[ch0]);
+    bad++;
+  }
+  if (parser.skipped) {
+    printf("raw: %llu bytes skipped\n", (unsigned long long)parser.skipped);
+    bad++;
+  }
+
+  std::vector<TiccSplitTime> out;
+  ticc_decode(debug, tb, params, TICC_MAX_CHANNELS, out, NULL, 0);
+  bad += check("debug", out, want);
+  ticc_decode(fromraw, tb, params, TICC_MAX_CHANNELS, out, NULL, 0);
+  bad += check("raw", out, want);
+
+  if (bad) {
+    printf("FAIL: %zu mismatches\n", bad);
+    return 1;
+  }
+  printf("OK: %zu events match the board\n", want.size());
+  return 0;
+}
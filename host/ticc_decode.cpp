@@ -0,0 +1,185 @@
+// ticc_decode.cpp -- convert a TICC Raw or Debug capture to timestamps
+//
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+//
+// Usage: ticc_decode [options] [capture]   (reads stdin if no file)
+//   -d            input is Debug-mode text rather than Raw-mode binary
+//   -b            input is FORMAT 'B' or 'D' binary frames (Timestamp,
+//                 Interval, Period or TimeLab mode); only -p, -w and -N apply
+//   -p places     decimal places (default 11)
+//   -w wrap       timestamp wrap digits (default 0)
+//   -j threads    decode threads (default: all cores)
+//   -c hz         CLOCK_HZ (default 10000000)
+//   -k ps         PICTICK_PS (default 100000000)
+//   -n periods    CAL_PERIODS (default 20)
+//   -C ch=prop,dilation,fixed_time2,fudge0
+//                 per-channel constants, e.g. -C 1=0,2500,0,-120
+//   -N names      channel names, e.g. -N AB (default AB...)
+// Output is one "timestamp chX" line per event in capture order.  With
+// -b, records print as the firmware's text would, overrun reports
+// included, except that a TimeLab chC line comes out as its interval
+// record "TI(A->B)".
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "ticc_raw.h"
+
+static void usage() {
+  fprintf(stderr, "usage: ticc_decode [-d | -b] [-p places] [-w wrap] [-j threads] [-c hz] [-k ps]\n"
+                  "                   [-n periods] [-C ch=prop,dil,ft2,fudge0] [-N names] [file]\n");
+  exit(2);
+}
+
+// FORMAT 'B' or 'D' capture: the board did the math, so just unframe and print
+static int decode_frames(FILE *in, const TiccChannelParams *params, int places, int32_t wrap) {
+  TiccFrameParser parser;
+  std::vector<TiccRecord> recs;
+  std::vector<uint8_t> buf(1 << 16);
+  uint16_t next_seq[TICC_MAX_CHANNELS];
+  bool seen[TICC_MAX_CHANNELS] = {false};
+  uint64_t gaps = 0;
+  char line[64];
+  size_t got;
+
+  while ((got = fread(buf.data(), 1, buf.size(), in)) > 0) {
+    recs.clear();
+    parser.feed(buf.data(), got, recs);
+    for (size_t i = 0; i < recs.size(); ++i) {
+      const TiccRecord &r = recs[i];
+      size_t n;
+      if (r.type == TICC_BIN_TYPE_TIMESTAMP) {
+        n = ticc_format_timestamp(line, sizeof(line) - 16, r.t, places, wrap);
+        n += (size_t)sprintf(line + n, " ch%c\n", params[r.chan].name);
+      } else if (r.type == TICC_BIN_TYPE_INTERVAL) {
+        n = ticc_format_signed(line, sizeof(line) - 16, r.t, places);
+        n += (size_t)sprintf(line + n, " TI(%c->%c)\n", 'A' + r.chan, 'B' + r.chan);
+      } else if (r.type == TICC_BIN_TYPE_PERIOD) {
+        n = ticc_format_signed(line, sizeof(line) - 16, r.t, places);
+        n += (size_t)sprintf(line + n, " ch%c\n", params[r.chan].name);
+      } else if (r.type == TICC_BIN_TYPE_OVERRUN) {
+        n = (size_t)sprintf(line, "# overrun ch%c queue %lu timeout %lu\n", params[r.chan].name,
+                            (unsigned long)r.queue, (unsigned long)r.timeouts);
+        fwrite(line, 1, n, stdout);
+        continue;
+      } else {
+        continue;
+      }
+      if (r.type != TICC_BIN_TYPE_INTERVAL) {  // per-channel sequence skipped: events lost
+        if (seen[r.chan] && r.seq != next_seq[r.chan]) gaps++;
+        seen[r.chan] = true;
+        next_seq[r.chan] = (uint16_t)(r.seq + 1);
+      }
+      fwrite(line, 1, n, stdout);
+    }
+  }
+  if (in != stdin) fclose(in);
+  if (parser.bad_frames) fprintf(stderr, "# %llu bad frames\n", (unsigned long long)parser.bad_frames);
+  if (gaps) fprintf(stderr, "# %llu sequence gaps\n", (unsigned long long)gaps);
+  if (parser.skipped_events)
+    fprintf(stderr, "# %llu delta events skipped\n", (unsigned long long)parser.skipped_events);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  TiccTimebase tb;
+  TiccChannelParams params[TICC_MAX_CHANNELS];
+  bool debug = false;
+  bool frames = false;
+  int places = 11;
+  int32_t wrap = 0;
+  unsigned threads = 0;
+  int opt;
+
+  for (int i = 0; i < TICC_MAX_CHANNELS; ++i) params[i].name = (char)('A' + i);
+
+  while ((opt = getopt(argc, argv, "dbp:w:j:c:k:n:C:N:")) != -1) {
+    switch (opt) {
+      case 'd': debug = true; break;
+      case 'b': frames = true; break;
+      case 'p': places = atoi(optarg); break;
+      case 'w': wrap = atoi(optarg); break;
+      case 'j': threads = (unsigned)atoi(optarg); break;
+      case 'c': tb.clock_hz = atoll(optarg); break;
+      case 'k': tb.pictick_ps = atoll(optarg); break;
+      case 'n': tb.cal_periods = (int16_t)atoi(optarg); break;
+      case 'C': {
+        int ch;
+        long long pd, td, ft2, f0;
+        if (sscanf(optarg, "%d=%lld,%lld,%lld,%lld", &ch, &pd, &td, &ft2, &f0) != 5 ||
+            ch < 0 || ch >= TICC_MAX_CHANNELS) usage();
+        params[ch].prop_delay = pd;
+        params[ch].time_dilation = td;
+        params[ch].fixed_time2 = ft2;
+        params[ch].fudge0 = f0;
+        break;
+      }
+      case 'N':
+        for (int i = 0; optarg[i] && i < TICC_MAX_CHANNELS; ++i) params[i].name = optarg[i];
+        break;
+      default: usage();
+    }
+  }
+  if ((debug && frames) || places < 0 || places > 12 || wrap < 0 || wrap > 9 ||
+      tb.clock_hz <= 0 || tb.pictick_ps <= 0 || tb.cal_periods < 2) usage();
+
+  FILE *in = stdin;
+  if (optind < argc) {
+    in = fopen(argv[optind], "rb");
+    if (!in) { perror(argv[optind]); return 1; }
+  }
+
+  if (frames) return decode_frames(in, params, places, wrap);
+
+  // Read and parse the whole capture, then decode it in one batch
+  TiccBatch batch;
+  TiccRawParser parser;
+  if (debug) {
+    char line[256];
+    while (fgets(line, sizeof(line), in)) {
+      ticc_parse_debug_line(line, params, TICC_MAX_CHANNELS, batch);
+    }
+  } else {
+    std::vector<uint8_t> buf(1 << 20);
+    size_t have = 0, got;
+    while ((got = fread(buf.data() + have, 1, buf.size() - have, in)) > 0) {
+      have += got;
+      size_t used = parser.feed(buf.data(), have, batch);
+      memmove(buf.data(), buf.data() + used, have - used);
+      have -= used;
+    }
+  }
+  if (in != stdin) fclose(in);
+
+  std::vector<TiccSplitTime> ts;
+  ticc_decode(batch, tb, params, TICC_MAX_CHANNELS, ts, NULL, threads);
+
+  char line[64];
+  for (size_t i = 0; i < ts.size(); ++i) {
+    size_t n = ticc_format_timestamp(line, sizeof(line) - 4, ts[i], places, wrap);
+    line[n++] = ' ';
+    line[n++] = 'c';
+    line[n++] = 'h';
+    line[n++] = params[batch.chan[i]].name;
+    line[n++] = '\n';
+    fwrite(line, 1, n, stdout);
+  }
+
+  if (!debug) {
+    for (int c = 0; c < TICC_MAX_CHANNELS; ++c) {
+      if (parser.timeouts[c]) fprintf(stderr, "# ch%c timeouts: %llu\n", params[c].name,
+                                      (unsigned long long)parser.timeouts[c]);
+      if (parser.uncal[c]) fprintf(stderr, "# ch%c: %llu events before the first calibration"
+                                   " record dropped\n", params[c].name,
+                                   (unsigned long long)parser.uncal[c]);
+    }
+    if (parser.skipped) fprintf(stderr, "# %llu bytes skipped\n", (unsigned long long)parser.skipped);
+  }
+  return 0;
+}
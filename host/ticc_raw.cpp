@@ -0,0 +1,443 @@
+// ticc_raw.cpp -- host-side decoder for TICC raw and Debug captures
+//
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+
+#include <stdio.h>
+#include <string.h>
+#include <functional>
+#include <thread>
+
+#include "ticc_raw.h"
+
+#define LSB_FRAC_BITS  24            // as in TICC/tdc7200.h
+#define MIN_PER_THREAD 65536         // don't start threads for small batches
+
+void TiccBatch::clear() {
+  chan.clear(); picstop.clear(); time1.clear(); time2.clear();
+  clock1.clear(); cal_diff.clear();
+}
+
+void TiccBatch::push(uint8_t ch, int64_t pic, uint32_t t1, uint32_t t2, uint32_t c1, uint32_t cal) {
+  chan.push_back(ch); picstop.push_back(pic); time1.push_back(t1);
+  time2.push_back(t2); clock1.push_back(c1); cal_diff.push_back(cal);
+}
+
+/*************************************************************************
+Parsing
+*************************************************************************/
+
+static uint64_t get_le(const uint8_t *p, int n) {
+  uint64_t v = 0;
+  while (n--) v = (v << 8) | p[n];
+  return v;
+}
+
+TiccRawParser::TiccRawParser() : skipped(0), in_text(false) {
+  memset(timeouts, 0, sizeof(timeouts));
+  memset(uncal, 0, sizeof(uncal));
+  memset(cal_diff, 0, sizeof(cal_diff));
+  memset(have_cal, 0, sizeof(have_cal));
+}
+
+size_t TiccRawParser::feed(const uint8_t *buf, size_t len, TiccBatch &out) {
+  size_t pos = 0;
+
+  while (pos < len) {
+    uint8_t b = buf[pos];
+
+    if (in_text) {                   // skip to the end of a text line
+      if (b == '\n') in_text = false;
+      pos++;
+      continue;
+    }
+    if (b != TICC_RAW_SYNC) {
+      if (b == '#') in_text = true;  // banner or menu output
+      else if (b != '\r' && b != '\n') skipped++;
+      pos++;
+      continue;
+    }
+
+    if (len - pos < 2) break;        // need the flags byte
+    uint8_t flags = buf[pos + 1];
+    uint8_t ch = flags & TICC_RAW_CHAN_MASK;
+    size_t need = (flags & TICC_RAW_FLAG_TIMEOUT) ? TICC_RAW_TIMEOUT_LEN :
+                  TICC_RAW_EVENT_LEN + ((flags & TICC_RAW_FLAG_CAL) ? TICC_RAW_CAL_LEN : 0);
+    if (len - pos < need) break;     // partial record; wait for more
+
+    const uint8_t *r = buf + pos;
+    int64_t pic = (int64_t)get_le(r + 2, 6);
+    if (flags & TICC_RAW_FLAG_TIMEOUT) {
+      timeouts[ch]++;
+    } else {
+      if (flags & TICC_RAW_FLAG_CAL) {
+        uint32_t cal1 = (uint32_t)get_le(r + 17, 3);
+        uint32_t cal2 = (uint32_t)get_le(r + 20, 3);
+        cal_diff[ch] = cal2 - cal1;
+        have_cal[ch] = true;
+      }
+      if (have_cal[ch]) {
+        out.push(ch, pic, (uint32_t)get_le(r + 8, 3), (uint32_t)get_le(r + 11, 3),
+                 (uint32_t)get_le(r + 14, 3), cal_diff[ch]);
+      } else {
+        uncal[ch]++;
+      }
+    }
+    pos += need;
+  }
+  return pos;
+}
+
+bool ticc_parse_debug_line(const char *line, const TiccChannelParams *params,
+                           size_t nchan, TiccBatch &out) {
+  unsigned long t1, t2, c1, cal1, cal2;
+  unsigned fresh, xfers;   // parsed past, not used
+  long long pic;
+  char name;
+
+  if (line[0] == '#') return false;
+  // Current firmware has cal_fresh and spi_xfers after cal2; earlier
+  // lines lack one or both, so count the fields before the chX tag (a
+  // sequence number may follow it)
+  size_t fields = 0;
+  for (const char *p = line; *p; ) {
+    while (*p == ' ' || *p == '\t') p++;
+    if (!*p || *p == '\r' || *p == '\n' || (p[0] == 'c' && p[1] == 'h')) break;
+    fields++;
+    while (*p && *p != ' ' && *p != '\t') p++;
+  }
+  int got;   // conversions made minus conversions expected
+  switch (fields) {
+    case 10:
+      got = sscanf(line, "%lu %lu %lu %lu %lu %u %u %lld %*s %*s ch%c", &t1, &t2, &c1,
+                   &cal1, &cal2, &fresh, &xfers, &pic, &name) - 9;
+      break;
+    case 9:
+      got = sscanf(line, "%lu %lu %lu %lu %lu %u %lld %*s %*s ch%c",
+                   &t1, &t2, &c1, &cal1, &cal2, &xfers, &pic, &name) - 8;
+      break;
+    case 8:
+      got = sscanf(line, "%lu %lu %lu %lu %lu %lld %*s %*s ch%c",
+                   &t1, &t2, &c1, &cal1, &cal2, &pic, &name) - 7;
+      break;
+    default:
+      return false;
+  }
+  if (got != 0) return false;
+  uint8_t ch = 0;
+  for (size_t i = 0; i < nchan; ++i) {
+    if (params[i].name == name) { ch = (uint8_t)i; break; }
+  }
+  out.push(ch, (int64_t)pic, (uint32_t)t1, (uint32_t)t2, (uint32_t)c1,
+           (uint32_t)cal2 - (uint32_t)cal1);
+  return true;
+}
+
+/*************************************************************************
+Binary frames
+*************************************************************************/
+
+uint16_t ticc_crc16(const uint8_t *p, size_t n) {
+  uint16_t crc = 0xFFFF;
+  while (n--) {
+    uint8_t x = (uint8_t)((crc >> 8) ^ *p++);
+    x ^= x >> 4;
+    crc = (uint16_t)((crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x);
+  }
+  return crc;
+}
+
+// Undo COBS on one frame (delimiter already stripped); returns the
+// record length, or 0 if the frame is malformed
+static size_t unstuff(const uint8_t *f, size_t n, uint8_t *rec) {
+  size_t o = 0, i = 0;
+  while (i < n) {
+    uint8_t code = f[i++];
+    if (code == 0 || i + code - 1 > n) return 0;
+    for (uint8_t k = 1; k < code; ++k) rec[o++] = f[i++];
+    if (code < 0xFF && i < n) rec[o++] = 0;
+  }
+  return o;
+}
+
+// Fixed-length record (TICC/misc.h)
+static bool decode_record(const uint8_t *rec, TiccRecord &r) {
+  uint64_t frac = get_le(rec + 7, 5);
+  r.type = rec[0] >> 4;
+  r.chan = rec[0] & 0x0F;
+  r.seq = (uint16_t)get_le(rec + 1, 2);
+  if (r.type == TICC_BIN_TYPE_OVERRUN) {
+    r.t.sec = 0;
+    r.t.frac_hi = 0;
+    r.t.frac_lo = 0;
+    r.queue = (uint32_t)get_le(rec + 3, 4);
+    r.timeouts = (uint32_t)get_le(rec + 7, 4);
+    return true;
+  }
+  r.queue = 0;
+  r.timeouts = 0;
+  r.t.sec = (int32_t)(uint32_t)get_le(rec + 3, 4);
+  r.t.frac_lo = (uint32_t)(frac & 0xFFFFF);
+  r.t.frac_hi = (uint32_t)(frac >> 20);
+  return (r.t.frac_lo < 1000000) && (r.t.frac_hi < 1000000);
+}
+
+// t + ps, normalized
+static TiccSplitTime add_ps(const TiccSplitTime &t, int64_t ps) {
+  int64_t rem = (int64_t)t.frac_hi * 1000000LL + t.frac_lo + ps;
+  int64_t sec = rem / TICC_PS_PER_SEC;
+  rem %= TICC_PS_PER_SEC;
+  if (rem < 0) {
+    rem += TICC_PS_PER_SEC;
+    sec -= 1;
+  }
+  TiccSplitTime r;
+  r.sec = (int32_t)(t.sec + sec);
+  r.frac_hi = (uint32_t)(rem / 1000000LL);
+  r.frac_lo = (uint32_t)(rem % 1000000LL);
+  return r;
+}
+
+TiccFrameParser::TiccFrameParser()
+    : bad_frames(0), skipped_events(0), frame_len(0), overflow(false), in_text(false) {
+  for (size_t c = 0; c < TICC_MAX_CHANNELS; ++c) chain[c].synced = false;
+}
+
+// Check and decode one frame, appending what it holds to out
+void TiccFrameParser::decode_frame(const uint8_t *f, size_t n, std::vector<TiccRecord> &out) {
+  uint8_t rec[TICC_BIN_FRAME_MAX];
+  size_t len = unstuff(f, n, rec);
+  if (len < 3 || ticc_crc16(rec, len - 2) != (uint16_t)get_le(rec + len - 2, 2)) {
+    bad_frames++;
+    return;
+  }
+  len -= 2;
+
+  TiccRecord r;
+  if ((rec[0] >> 4) != TICC_BIN_TYPE_DELTA) {
+    if (len != TICC_BIN_RECORD_LEN - 2 || !decode_record(rec, r)) {
+      bad_frames++;
+      return;
+    }
+    if (r.type == TICC_BIN_TYPE_TIMESTAMP) {  // a delta chain's base
+      Chain &c = chain[r.chan];
+      c.last = r.t;
+      c.last_d1 = 0;
+      c.next_seq = (uint16_t)(r.seq + 1);
+      c.synced = true;
+    }
+    out.push_back(r);
+    return;
+  }
+
+  // one zigzag varint per event; the last must be complete
+  if (len < 4 || (rec[len - 1] & 0x80)) {
+    bad_frames++;
+    return;
+  }
+  r.type = TICC_BIN_TYPE_TIMESTAMP;
+  r.chan = rec[0] & 0x0F;
+  r.seq = (uint16_t)get_le(rec + 1, 2);
+  Chain &c = chain[r.chan];
+  if (!c.synced || r.seq != c.next_seq) {
+    c.synced = false;
+    for (size_t i = 3; i < len; ++i) {
+      if (!(rec[i] & 0x80)) skipped_events++;
+    }
+    return;
+  }
+  uint64_t z = 0;
+  unsigned shift = 0;
+  for (size_t i = 3; i < len; ++i) {
+    if (shift < 64) z |= (uint64_t)(rec[i] & 0x7F) << shift;
+    shift += 7;
+    if (rec[i] & 0x80) continue;
+    int64_t d2 = (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+    c.last_d1 += d2;
+    c.last = add_ps(c.last, c.last_d1);
+    r.t = c.last;
+    out.push_back(r);
+    r.seq++;
+    z = 0;
+    shift = 0;
+  }
+  c.next_seq = r.seq;
+}
+
+void TiccFrameParser::feed(const uint8_t *buf, size_t len, std::vector<TiccRecord> &out) {
+  for (size_t pos = 0; pos < len; ++pos) {
+    uint8_t b = buf[pos];
+
+    if (in_text) {                   // skip to the end of a text line
+      if (b == '\n') in_text = false;
+      continue;
+    }
+    if (frame_len == 0 && !overflow && b == '#') {
+      in_text = true;                // a record's COBS code byte is never '#'
+      continue;
+    }
+    if (b != 0) {
+      if (frame_len < TICC_BIN_FRAME_MAX) frame[frame_len++] = b;
+      else overflow = true;
+      continue;
+    }
+
+    if (frame_len) {
+      if (!overflow) decode_frame(frame, frame_len, out);
+      else bad_frames++;
+    }
+    frame_len = 0;
+    overflow = false;
+  }
+}
+
+/*************************************************************************
+Decoding
+*************************************************************************/
+
+// tdc7200Channel::update_lsb()
+static uint32_t lsb_q24_for(uint32_t cal_diff, int64_t time_dilation,
+                            int16_t cal_periods, int64_t clock_period) {
+  int64_t calCount = ((int64_t)cal_diff * (int64_t)(1000000 - time_dilation)) / (int64_t)(cal_periods - 1);
+  if (calCount <= 0) return 0;
+  int64_t normLSB = (clock_period * (int64_t)1000000000000) / calCount;
+  return (uint32_t)(((normLSB << LSB_FRAC_BITS) + 500000) / 1000000);
+}
+
+// One contiguous slice of the batch.  Every event is independent: the
+// firmware's incremental coarse split always equals PICstop / ticks and
+// PICstop % ticks, and the LSB is a pure function of the calibration,
+// cached here per channel just as the firmware does.
+static void decode_range(const TiccBatch &b, const TiccTimebase &tb,
+                         const TiccChannelParams *params, size_t nchan,
+                         TiccSplitTime *out, int64_t *tof_out,
+                         size_t lo, size_t hi) {
+  const int64_t period = TICC_PS_PER_SEC / tb.clock_hz;
+  const int64_t tick = tb.pictick_ps;
+  const int64_t tps = TICC_PS_PER_SEC / tick;
+
+  uint32_t lsb_cal[TICC_MAX_CHANNELS];
+  uint32_t lsb[TICC_MAX_CHANNELS];
+  for (size_t c = 0; c < TICC_MAX_CHANNELS; ++c) {
+    lsb_cal[c] = 0;
+    lsb[c] = 0;
+  }
+
+  for (size_t i = lo; i < hi; ++i) {
+    uint8_t ch = b.chan[i];
+    const TiccChannelParams &p = params[(ch < nchan) ? ch : 0];
+
+    // compute_tof()
+    uint32_t cal = b.cal_diff[i];
+    if (cal != lsb_cal[ch]) {
+      lsb_cal[ch] = cal;
+      lsb[ch] = lsb_q24_for(cal, p.time_dilation, tb.cal_periods, period);
+    }
+    int64_t tof = (int64_t)b.clock1[i] * period;
+    uint32_t t2 = p.fixed_time2 ? (uint32_t)p.fixed_time2 : b.time2[i];
+    int32_t ring_ticks = (int32_t)b.time1[i] - (int32_t)t2;
+    uint32_t ring_mag = (ring_ticks < 0) ? (uint32_t)(-ring_ticks) : (uint32_t)ring_ticks;
+    int32_t ring_ps = (int32_t)(((uint64_t)ring_mag * lsb[ch]) >> LSB_FRAC_BITS);
+    if (ring_ticks < 0) ring_ps = -ring_ps;
+    tof += ring_ps;
+    if (tof_out) tof_out[i] = tof;
+
+    // stamp_channel(); offset as in tdc7200Channel::set_offset()
+    int64_t sec = (int32_t)(b.picstop[i] / tps);
+    int64_t remPs = (int64_t)(int32_t)(b.picstop[i] % tps) * tick;
+    remPs -= tof + (p.prop_delay - (p.prop_delay + p.fudge0));
+    int64_t carry = remPs / TICC_PS_PER_SEC;
+    remPs -= carry * TICC_PS_PER_SEC;
+    if (remPs < 0) {
+      remPs += TICC_PS_PER_SEC;
+      carry -= 1;
+    }
+    sec += carry;
+    out[i].sec = (int32_t)sec;
+    out[i].frac_hi = (uint32_t)(remPs / 1000000LL);
+    out[i].frac_lo = (uint32_t)(remPs % 1000000LL);
+  }
+}
+
+void ticc_decode(const TiccBatch &batch, const TiccTimebase &tb,
+                 const TiccChannelParams *params, size_t nchan,
+                 std::vector<TiccSplitTime> &out, std::vector<int64_t> *tof,
+                 unsigned threads) {
+  size_t n = batch.size();
+  out.resize(n);
+  if (tof) tof->resize(n);
+  int64_t *tof_p = tof ? tof->data() : NULL;
+
+  if (threads == 0) threads = std::thread::hardware_concurrency();
+  if (threads == 0) threads = 1;
+  if (n / MIN_PER_THREAD < threads) threads = (unsigned)(n / MIN_PER_THREAD);
+  if (threads <= 1) {
+    decode_range(batch, tb, params, nchan, out.data(), tof_p, 0, n);
+    return;
+  }
+
+  std::vector<std::thread> pool;
+  size_t step = (n + threads - 1) / threads;
+  for (size_t lo = 0; lo < n; lo += step) {
+    size_t hi = (lo + step < n) ? lo + step : n;
+    pool.emplace_back(decode_range, std::cref(batch), std::cref(tb), params, nchan,
+                      out.data(), tof_p, lo, hi);
+  }
+  for (size_t t = 0; t < pool.size(); ++t) pool[t].join();
+}
+
+/*************************************************************************
+Formatting (same output as misc.cpp)
+*************************************************************************/
+
+static const uint32_t POW10[10] = {
+  1UL, 10UL, 100UL, 1000UL, 10000UL,
+  100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+static char *append_u32(char *p, const char *end, uint32_t v, uint8_t width) {
+  char tmp[10];
+  uint8_t n = 0;
+  do { tmp[n++] = (char)('0' + (v % 10)); v /= 10; } while (v);
+  for (uint8_t i = n; i < width; ++i) { if (p < end) *p++ = '0'; }
+  while (n--) { if (p < end) *p++ = tmp[n]; }
+  return p;
+}
+
+size_t ticc_format_timestamp(char *buf, size_t cap, const TiccSplitTime &t,
+                             int places, int32_t wrap) {
+  char *p = buf;
+  const char *end = buf + cap;
+  int32_t sec = t.sec;
+  bool neg = (sec < 0);
+  uint32_t s = (uint32_t)(neg ? -sec : sec);
+
+  if (neg && p < end) *p++ = '-';
+  if (wrap <= 0) p = append_u32(p, end, s, 1);
+  else p = append_u32(p, end, s % POW10[(uint8_t)wrap], (uint8_t)wrap);
+  if (p < end) *p++ = '.';
+  if (places <= 6) {
+    if (places > 0) p = append_u32(p, end, t.frac_hi / POW10[6 - places], (uint8_t)places);
+  } else {
+    p = append_u32(p, end, t.frac_hi, 6);
+    p = append_u32(p, end, t.frac_lo / POW10[12 - places], (uint8_t)(places - 6));
+  }
+  if (p < end) *p = '\0';
+  return (size_t)(p - buf);
+}
+
+size_t ticc_format_signed(char *buf, size_t cap, const TiccSplitTime &t, int places) {
+  int64_t ps = (int64_t)t.sec * TICC_PS_PER_SEC + (int64_t)t.frac_hi * 1000000 + t.frac_lo;
+  uint64_t mag = (ps < 0) ? (uint64_t)(-ps) : (uint64_t)ps;
+  TiccSplitTime m;
+  char *p = buf;
+  const char *end = buf + cap;
+
+  if (ps < 0 && p < end) *p++ = '-';
+  m.sec = (int32_t)(mag / (uint64_t)TICC_PS_PER_SEC);
+  m.frac_hi = (uint32_t)((mag / 1000000) % 1000000);
+  m.frac_lo = (uint32_t)(mag % 1000000);
+  return (size_t)(p - buf) + ticc_format_timestamp(p, (size_t)(end - p), m, places, 0);
+}
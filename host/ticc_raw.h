@@ -0,0 +1,171 @@
+#ifndef TICC_RAW_H
+#define TICC_RAW_H
+
+// ticc_raw.h -- host-side decoder for TICC raw and Debug captures
+//
+// TICC Time interval Counter based on TICC Shield using TDC7200
+//
+// Copyright John Ackermann N8UR 2016-2025
+// Licensed under BSD 2-clause license
+//
+// Reproduces, bit for bit, the firmware's tdc7200Channel::compute_tof()
+// and the coarse-time split in stamp_channel() (TICC.ino) for batches
+// of events, so Raw-mode (A7) or Debug-mode captures can be turned into
+// timestamps off the board, or reprocessed with different calibration
+// constants.  Calibration is taken sample-and-hold (CAL_FILTER 'N'):
+// raw records only carry a calibration when it changed, which is not
+// enough to replay the IIR or median filters.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Raw record layout; must match the RAW_* defines in TICC/tdc7200.h
+#define TICC_RAW_SYNC          0xA5
+#define TICC_RAW_FLAG_CAL      0x80
+#define TICC_RAW_FLAG_TIMEOUT  0x40
+#define TICC_RAW_CHAN_MASK     0x0F
+#define TICC_RAW_TIMEOUT_LEN   8
+#define TICC_RAW_EVENT_LEN     17
+#define TICC_RAW_CAL_LEN       6
+
+#define TICC_MAX_CHANNELS      16
+#define TICC_PS_PER_SEC        1000000000000LL
+
+// Same split form as the firmware's SplitTime (misc.h)
+struct TiccSplitTime {
+  int32_t  sec;
+  uint32_t frac_hi;  // ps / 1e6
+  uint32_t frac_lo;  // ps % 1e6
+};
+
+// Timebase; defaults match config.h
+struct TiccTimebase {
+  int64_t clock_hz    = 10000000;   // CLOCK_HZ
+  int64_t pictick_ps  = 100000000;  // PICTICK_PS
+  int16_t cal_periods = 20;         // CAL_PERIODS
+};
+
+// Per-channel constants, as in config_t
+struct TiccChannelParams {
+  char    name          = 'A';
+  int64_t prop_delay    = 0;     // PROP_DELAY (cancels, as on the board)
+  int64_t time_dilation = 2500;  // TIME_DILATION
+  int64_t fixed_time2   = 0;     // FIXED_TIME2
+  int64_t fudge0        = 0;     // FUDGE0
+};
+
+// A batch of events, one entry per index in every array.  cal_diff is
+// the calibration in force for that event (CALIBRATION2 - CALIBRATION1).
+struct TiccBatch {
+  std::vector<uint8_t>  chan;
+  std::vector<int64_t>  picstop;
+  std::vector<uint32_t> time1;
+  std::vector<uint32_t> time2;
+  std::vector<uint32_t> clock1;
+  std::vector<uint32_t> cal_diff;
+
+  size_t size() const { return chan.size(); }
+  void clear();
+  void push(uint8_t ch, int64_t pic, uint32_t t1, uint32_t t2, uint32_t c1, uint32_t cal);
+};
+
+// Incremental raw-stream parser.  Feed capture bytes in any chunking;
+// text lines ('#' banner and menu output) between records are skipped.
+// The board only sends calibration when it changes, so a capture that
+// starts mid-stream can have events before a channel's first calibration
+// record; those can't be decoded and are counted in uncal instead.
+class TiccRawParser {
+public:
+  TiccRawParser();
+  // Append decoded events to out; returns the number of bytes consumed.
+  // Unconsumed bytes are a partial record: pass them again with more data.
+  size_t feed(const uint8_t *buf, size_t len, TiccBatch &out);
+  uint64_t timeouts[TICC_MAX_CHANNELS];  // RAW_FLAG_TIMEOUT records seen
+  uint64_t uncal[TICC_MAX_CHANNELS];     // events dropped before any calibration
+  uint64_t skipped;                      // bytes skipped while resyncing
+private:
+  uint32_t cal_diff[TICC_MAX_CHANNELS];  // last calibration per channel
+  bool     have_cal[TICC_MAX_CHANNELS];  // cal_diff has been set
+  bool     in_text;                      // inside a '#' comment line
+};
+
+// Parse one Debug-mode output line ("time1 time2 clock1 cal1 cal2
+// cal_fresh spi_xfers PICstop tof timestamp chX [seq]", or the older
+// layouts without cal_fresh and spi_xfers); returns false for anything
+// else.
+// chan is looked up by name in params; unknown names map to channel 0.
+bool ticc_parse_debug_line(const char *line, const TiccChannelParams *params,
+                           size_t nchan, TiccBatch &out);
+
+// Decode a batch into timestamps (out is resized to batch.size()) and,
+// optionally, tof in ps.  threads == 0 uses the hardware concurrency.
+void ticc_decode(const TiccBatch &batch, const TiccTimebase &tb,
+                 const TiccChannelParams *params, size_t nchan,
+                 std::vector<TiccSplitTime> &out, std::vector<int64_t> *tof,
+                 unsigned threads);
+
+// Binary output (FORMAT 'B'); must match the BIN_* defines in TICC/misc.h.
+// Frames are COBS-encoded records ended by 0x00.
+#define TICC_BIN_TYPE_TIMESTAMP 1
+#define TICC_BIN_TYPE_INTERVAL  2
+#define TICC_BIN_TYPE_PERIOD    3
+#define TICC_BIN_TYPE_DELTA     4    // FORMAT 'D': varint second differences
+#define TICC_BIN_TYPE_OVERRUN   5    // SEQUENCE 'Y' loss report
+#define TICC_BIN_RECORD_LEN     14
+#define TICC_BIN_FRAME_MAX      64   // longer runs between delimiters are garbage
+
+// One decoded binary record.  The value is sec + frac (frac >= 0 even
+// when sec is negative).  chan is the pair's first channel for intervals.
+// An overrun record has no value; it carries the channel's running loss
+// counts instead.
+struct TiccRecord {
+  uint8_t       type;   // TICC_BIN_TYPE_*
+  uint8_t       chan;
+  uint16_t      seq;    // low 16 bits of the channel's event number
+  TiccSplitTime t;
+  uint32_t      queue;     // overrun: records dropped by the overload policy
+  uint32_t      timeouts;  // overrun: TDC timeouts
+};
+
+// Incremental parser for FORMAT 'B' and 'D' streams.  Feed capture
+// bytes in any chunking; '#' comment lines between frames are skipped,
+// and frames that fail COBS decoding, length or CRC checks are counted
+// and dropped.  Delta frames are expanded into one timestamp record per
+// event.  A delta frame that doesn't follow on from the channel's last
+// record (one was lost) can't be placed; its events are counted in
+// skipped_events until the next full record.
+class TiccFrameParser {
+public:
+  TiccFrameParser();
+  // Append decoded records to out; all of buf is consumed
+  void feed(const uint8_t *buf, size_t len, std::vector<TiccRecord> &out);
+  uint64_t bad_frames;                   // COBS, length or CRC failures
+  uint64_t skipped_events;               // delta events with no base
+private:
+  struct Chain {
+    TiccSplitTime last;
+    int64_t  last_d1;
+    uint16_t next_seq;
+    bool     synced;
+  };
+  void decode_frame(const uint8_t *f, size_t n, std::vector<TiccRecord> &out);
+  uint8_t frame[TICC_BIN_FRAME_MAX];
+  size_t  frame_len;
+  bool    overflow;                      // current frame too long
+  bool    in_text;                       // inside a '#' comment line
+  Chain   chain[TICC_MAX_CHANNELS];      // per-channel delta state
+};
+
+// CRC-16/CCITT-FALSE as used in binary records
+uint16_t ticc_crc16(const uint8_t *p, size_t n);
+
+// Format a signed sec + frac value (intervals, periods) as
+// [-]seconds.places, truncated toward zero
+size_t ticc_format_signed(char *buf, size_t cap, const TiccSplitTime &t, int places);
+
+// Format a timestamp exactly as the firmware's formatTimestampSplitTo()
+size_t ticc_format_timestamp(char *buf, size_t cap, const TiccSplitTime &t,
+                             int places, int32_t wrap);
+
+#endif /* TICC_RAW_H */